@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif // #ifdef WIN32
+
+#include "async_log.h"
+#include "util_func.h"
+
+
+/**
+*  -------------------------------------------------------  *
+*  LOGGERIDLE() lets the logger sleep for ALOG_IDLE ms.
+*  -------------------------------------------------------  *
+*/
+static void LoggerIdle (void)
+{
+#ifdef WIN32
+	Sleep(ALOG_IDLE);
+#else
+	struct timespec Idle = {0, ALOG_IDLE * 1000000L};
+
+	nanosleep(&Idle, NULL);
+#endif // #ifdef WIN32
+} // End: LoggerIdle()
+
+
+/**
+*  -------------------------------------------------------  *
+*  LOGGER() is the logger thread: it moves the records of
+*  the ring to the log in batches of up to ALOG_BATCH, so
+*  page faults and file writes never hit the control loop.
+*  When stopped, it drains the ring and quits.
+*  -------------------------------------------------------  *
+*/
+static void *Logger (void *pArg)
+{
+	ASYNCLOG *ALog = pArg;
+
+	unsigned uHead, uTail, n;
+
+	uTail = ALog->uTail;
+
+	while (1)
+	{
+		uHead = __atomic_load_n(&ALog->uHead, __ATOMIC_ACQUIRE);
+
+		if (uHead == uTail)
+		{
+			if (__atomic_load_n(&ALog->bStop, __ATOMIC_ACQUIRE))
+			{
+				/* a last push may have come before the stop */
+				if (__atomic_load_n(&ALog->uHead, __ATOMIC_ACQUIRE) == uTail)
+					break;
+
+				continue;
+			}
+
+			LoggerIdle();
+			continue;
+		}
+
+		for (n = 0; uTail != uHead && n < ALOG_BATCH; n++, uTail++)
+			LogWrite(ALog->Log, ALog->Ring[uTail % ALOG_RING].lfValue);
+
+		/* hand the slots back to the producer */
+		__atomic_store_n(&ALog->uTail, uTail, __ATOMIC_RELEASE);
+	}
+
+	return NULL;
+} // End: Logger()
+
+
+/**
+*  -------------------------------------------------------  *
+*  ASYNCLOGOPEN() opens a binary log (see LogOpen()) that
+*  is written by a background thread.
+*
+*  Inputs:
+*     cFileName  : name of the file to save data into
+*     lfTs       : sampling time
+*     uCapacity  : maximum number of samples
+*     uNbrChan   : number of channels
+*     cChanNames : channel names
+*
+*  Outputs:
+*     ALog: pointer to the log, NULL on failure
+*  -------------------------------------------------------  *
+*/
+ASYNCLOG *AsyncLogOpen (
+		   const char *cFileName,
+		   double lfTs,
+		   unsigned uCapacity,
+		   unsigned uNbrChan,
+		   const char **cChanNames
+		   )
+{
+	ASYNCLOG *ALog;
+
+	ALog = calloc(1, sizeof(ASYNCLOG));
+	if (ALog != NULL)
+		ALog->Ring = malloc(sizeof(LOGRECORD) * ALOG_RING);
+
+	if (ALog == NULL || ALog->Ring == NULL)
+	{
+		puts("Error: memory allocaion failed!\n");
+		free(ALog);
+		return NULL;
+	}
+
+	ALog->Log = LogOpen(cFileName, lfTs, uCapacity, uNbrChan, cChanNames);
+	if (ALog->Log == NULL)
+	{
+		free(ALog->Ring);
+		free(ALog);
+		return NULL;
+	}
+
+	if (pthread_create(&ALog->Thread, NULL, Logger, ALog) != 0)
+	{
+		puts("Error: logger thread cannot be started!\n");
+		LogClose(ALog->Log);
+		free(ALog->Ring);
+		free(ALog);
+		return NULL;
+	}
+
+	return ALog;
+} // End: AsyncLogOpen()
+
+
+/**
+*  -------------------------------------------------------  *
+*  ASYNCLOGPUSH() queues one sample for the logger. It ne-
+*  ver waits: on a full ring the sample is dropped and co-
+*  unted.
+*
+*  Inputs:
+*     *ALog    : pointer to an open log
+*     *lfSample: one value per channel of the log
+*
+*  Outputs:
+*     0 if queued, -1 if dropped
+*  -------------------------------------------------------  *
+*/
+int AsyncLogPush (ASYNCLOG *ALog, const double *lfSample)
+{
+	unsigned uHead, uFill;
+
+	uHead = ALog->uHead;
+	uFill = uHead - __atomic_load_n(&ALog->uTail, __ATOMIC_ACQUIRE);
+
+	if (uFill >= ALOG_RING)
+	{
+		ALog->uNbrDrop++;
+		return -1;
+	}
+
+	memcpy(ALog->Ring[uHead % ALOG_RING].lfValue, lfSample, sizeof(double) * ALog->Log->Header->uNbrChan);
+
+	__atomic_store_n(&ALog->uHead, uHead + 1, __ATOMIC_RELEASE);
+
+	if (uFill + 1 > ALog->uHighWater)
+		ALog->uHighWater = uFill + 1;
+
+	return 0;
+} // End: AsyncLogPush()
+
+
+/**
+*  -------------------------------------------------------  *
+*  ASYNCLOGREPORT() prints the counters of the ring. To be
+*  called from the producer thread.
+*
+*  Inputs:
+*     *ALog: pointer to an open log
+*  -------------------------------------------------------  *
+*/
+void AsyncLogReport (const ASYNCLOG *ALog)
+{
+	printf("log: %u samples queued, %u dropped, ring high water %u of %d\n",
+	       ALog->uHead, ALog->uNbrDrop, ALog->uHighWater, ALOG_RING);
+
+} // End: AsyncLogReport()
+
+
+/**
+*  -------------------------------------------------------  *
+*  ASYNCLOGCLOSE() lets the logger write the queued samp-
+*  les, stops it and closes the log.
+*
+*  Inputs:
+*     *ALog: pointer to an open log
+*  -------------------------------------------------------  *
+*/
+void AsyncLogClose (ASYNCLOG *ALog)
+{
+	if (ALog == NULL)
+		return;
+
+	__atomic_store_n(&ALog->bStop, TRUE, __ATOMIC_RELEASE);
+	pthread_join(ALog->Thread, NULL);
+
+	LogClose(ALog->Log);
+	free(ALog->Ring);
+	free(ALog);
+
+} // End: AsyncLogClose()
@@ -0,0 +1,41 @@
+#ifndef __ASYNC_LOG_H__
+#define __ASYNC_LOG_H__
+
+#include <pthread.h>
+
+#include "data_treatment.h"
+
+#define ALOG_RING    4096   // records in the ring (power of two)
+#define ALOG_BATCH   256    // records written by the logger at once
+#define ALOG_IDLE    1      // logger sleep when the ring is empty [ms]
+#define ALOG_LINE    64     // cache line size
+
+// one sample as it travels through the ring
+typedef struct tagLogRecord {
+	double lfValue[LOG_MAX_CHAN];
+} LOGRECORD;
+
+/* single-producer/single-consumer ring in front of a binary log:
+   the control loop pushes, a logger thread writes */
+typedef struct tagAsyncLog {
+	unsigned      uHead;		// next record to push (producer)
+	unsigned      uNbrDrop;		// records lost on a full ring (producer)
+	unsigned      uHighWater;	// largest ring fill seen (producer)
+	char          cPad1[ALOG_LINE - 3 * sizeof(unsigned)];
+	unsigned      uTail;		// next record to write (logger)
+	unsigned char bStop;		// the logger has to drain and quit
+	char          cPad2[ALOG_LINE - sizeof(unsigned) - 1];
+	LOGRECORD    *Ring;			// ALOG_RING records
+	LOGFILE      *Log;			// destination
+	pthread_t     Thread;		// logger thread
+} ASYNCLOG;
+
+ASYNCLOG *AsyncLogOpen (const char *cFileName, double lfTs, unsigned uCapacity, unsigned uNbrChan, const char **cChanNames);
+
+int AsyncLogPush (ASYNCLOG *ALog, const double *lfSample);
+
+void AsyncLogReport (const ASYNCLOG *ALog);
+
+void AsyncLogClose (ASYNCLOG *ALog);
+
+#endif // __ASYNC_LOG_H__
@@ -0,0 +1,244 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "batch_sim.h"
+#include "simulation.h"
+#include "util_func.h"
+
+#define BATCH_NBR_ARRAYS   17   // number of float arrays in BATCHSIM
+
+#define ALIGNED(p)   ((float *)__builtin_assume_aligned((p), BATCH_ALIGN * sizeof(float)))
+
+
+/**
+*  -------------------------------------------------------  *
+*  BATCHINIT() allocates a batch of closed loops. Every
+*  state variable is stored as one contiguous, aligned and
+*  padded array so that the compiler can advance 8 (AVX2)
+*  or 16 (AVX-512) loops per instruction.
+*
+*  Inputs:
+*     *Batch   : pointer to the batch to initialize
+*     uNbrLoops: number of loops
+*
+*  Outputs:
+*     0 on success, -1 if memory allocation failed
+*  -------------------------------------------------------  *
+*/
+int BatchInit (BATCHSIM *Batch, unsigned uNbrLoops)
+{
+	size_t   uBytes;
+
+	float   *fBase;
+
+	float  **fArrays[BATCH_NBR_ARRAYS];
+
+	unsigned i;
+
+	Batch->uNbrLoops = uNbrLoops;
+	Batch->uStride   = (uNbrLoops + BATCH_ALIGN - 1) / BATCH_ALIGN * BATCH_ALIGN;
+
+	/* one block for all arrays, plus room for the alignment */
+	uBytes = (size_t)BATCH_NBR_ARRAYS * Batch->uStride * sizeof(float) + BATCH_ALIGN * sizeof(float);
+	Batch->pBlock = calloc(1, uBytes);
+
+	if (Batch->pBlock == NULL)
+	{
+		puts("Error: memory allocaion failed!\n");
+		return -1;
+	}
+
+	fBase = (float *)(((size_t)Batch->pBlock + BATCH_ALIGN * sizeof(float) - 1) & ~(size_t)(BATCH_ALIGN * sizeof(float) - 1));
+
+	fArrays[0]  = &Batch->fR;
+	fArrays[1]  = &Batch->fY1;
+	fArrays[2]  = &Batch->fY2;
+	fArrays[3]  = &Batch->fY3;
+	fArrays[4]  = &Batch->fU1;
+	fArrays[5]  = &Batch->fU2;
+	fArrays[6]  = &Batch->fU3;
+	fArrays[7]  = &Batch->fI;
+	fArrays[8]  = &Batch->fD;
+	fArrays[9]  = &Batch->fYOld;
+	fArrays[10] = &Batch->fK;
+	fArrays[11] = &Batch->fKd1;
+	fArrays[12] = &Batch->fKd2;
+	fArrays[13] = &Batch->fKi;
+	fArrays[14] = &Batch->fKt;
+	fArrays[15] = &Batch->fU;
+	fArrays[16] = &Batch->fY;
+
+	for (i = 0; i < BATCH_NBR_ARRAYS; i++)
+		*fArrays[i] = fBase + (size_t)i * Batch->uStride;
+
+	return 0;
+} // End: BatchInit()
+
+
+/**
+*  -------------------------------------------------------  *
+*  BATCHSETLOOP() assigns the PID gains and set-point of
+*  one loop in the batch and clears its memory. The con-
+*  troller constants are derived here once, so the kernel
+*  only performs multiply-adds.
+*
+*  Inputs:
+*     *Batch   : pointer to the batch
+*     uLoop    : index of the loop
+*     *PID     : pointer to a PID structure
+*     fSetpoint: set-point
+*     fTs      : sampling time
+*  -------------------------------------------------------  *
+*/
+void BatchSetLoop (
+		   BATCHSIM *Batch,
+		   unsigned uLoop,
+		   const PIDSET *PID,
+		   float fSetpoint,
+		   float fTs
+		   )
+{
+	PIDCOEF Coef;
+
+	Batch->fR[uLoop] = (int)lrintf(fSetpoint * PREC);	// 1/PREC steps, like CASESET
+
+	/* controller constants, same as in PIDCtrl() */
+	Coef = PIDCompile(PID, fTs);
+
+	Batch->fK[uLoop]   = Coef.fK;
+	Batch->fKd1[uLoop] = Coef.fKd1;
+	Batch->fKd2[uLoop] = Coef.fKd2;
+	Batch->fKi[uLoop]  = Coef.fKi;
+	Batch->fKt[uLoop]  = Coef.fKt;
+
+	/* loop memory */
+	Batch->fY1[uLoop]   = 0;
+	Batch->fY2[uLoop]   = 0;
+	Batch->fY3[uLoop]   = 0;
+	Batch->fU1[uLoop]   = 0;
+	Batch->fU2[uLoop]   = 0;
+	Batch->fU3[uLoop]   = 0;
+	Batch->fI[uLoop]    = 0;
+	Batch->fD[uLoop]    = 0;
+	Batch->fYOld[uLoop] = 0;
+	Batch->fU[uLoop]    = 0;
+	Batch->fY[uLoop]    = 0;
+
+} // End: BatchSetLoop()
+
+
+/**
+*  -------------------------------------------------------  *
+*  BATCHSTEP() advances every loop in the batch by a num-
+*  ber of samples. It evaluates the same difference equa-
+*  tion as Sys2ndOrder() and the same control law as PID-
+*  Ctrl(), with the same rounding: the output and the com-
+*  mand are truncated to 1/PREC like the short signals of
+*  LoopStep(). A loop of the batch follows a MANUAL loop
+*  of LoopStep() sample for sample, one sample ahead (the
+*  MANUAL case spends its first sample switching on).
+*
+*  The loops are processed in blocks of BATCH_BLOCK, so
+*  the state of one block stays in cache for all samples.
+*  Padding lanes have zero gains and remain at rest.
+*
+*  Inputs:
+*     *Batch  : pointer to the batch
+*     uNbrIter: number of samples
+*  -------------------------------------------------------  *
+*/
+void BatchStep (BATCHSIM *Batch, unsigned uNbrIter)
+{
+	unsigned b, j, k, m;
+
+	for (b = 0; b < Batch->uStride; b += BATCH_BLOCK)
+	{
+		float * __restrict__ fR    = ALIGNED(Batch->fR    + b);
+		float * __restrict__ fY1   = ALIGNED(Batch->fY1   + b);
+		float * __restrict__ fY2   = ALIGNED(Batch->fY2   + b);
+		float * __restrict__ fY3   = ALIGNED(Batch->fY3   + b);
+		float * __restrict__ fU1   = ALIGNED(Batch->fU1   + b);
+		float * __restrict__ fU2   = ALIGNED(Batch->fU2   + b);
+		float * __restrict__ fU3   = ALIGNED(Batch->fU3   + b);
+		float * __restrict__ fI    = ALIGNED(Batch->fI    + b);
+		float * __restrict__ fD    = ALIGNED(Batch->fD    + b);
+		float * __restrict__ fYOld = ALIGNED(Batch->fYOld + b);
+		float * __restrict__ fK    = ALIGNED(Batch->fK    + b);
+		float * __restrict__ fKd1  = ALIGNED(Batch->fKd1  + b);
+		float * __restrict__ fKd2  = ALIGNED(Batch->fKd2  + b);
+		float * __restrict__ fKi   = ALIGNED(Batch->fKi   + b);
+		float * __restrict__ fKt   = ALIGNED(Batch->fKt   + b);
+		float * __restrict__ fU    = ALIGNED(Batch->fU    + b);
+		float * __restrict__ fY    = ALIGNED(Batch->fY    + b);
+
+		m = min(BATCH_BLOCK, Batch->uStride - b);
+
+		for (k = 0; k < uNbrIter; k++)
+		{
+			/* the arrays never overlap */
+			#pragma GCC ivdep
+			for (j = 0; j < m; j++)
+			{
+				float fYk, fYs, fUk, fE, fDk, fV;
+
+				int iUs;
+
+				/* plant response, summed in double as by Sys2ndOrder() */
+				fYk = SYS_A1 * fY1[j] + SYS_A2 * fY2[j] + SYS_A3 * fY3[j]
+				    + SYS_B1 * fU1[j] + SYS_B2 * fU2[j] + SYS_B3 * fU3[j];
+
+				fY3[j] = fY2[j];
+				fY2[j] = fY1[j];
+				fY1[j] = fYk;
+
+				/* the plant takes the last command, as with LoopStep() */
+				fU3[j] = fU2[j];
+				fU2[j] = fU1[j];
+				fU1[j] = fU[j];
+
+				/* measured output in 1/PREC steps, truncated as by Sys2ndOrder() */
+				fYs = (float)(int)(fYk * PREC);
+
+				/* PID controller */
+				fE  = (fR[j] - fYs) / PREC;
+				fDk = fKd1[j] * fD[j] - fKd2[j] * ((fYs - fYOld[j]) / PREC);
+				fV  = fK[j] * fE + fI[j] + fDk;
+
+				/* command truncated to 1/PREC, then saturated, as by PIDCtrl() */
+				iUs = fV * PREC;
+				iUs = iUs < UMIN * PREC ? UMIN * PREC : iUs;
+				iUs = iUs > UMAX * PREC ? UMAX * PREC : iUs;
+				fUk = (float)iUs / PREC;
+
+				fI[j]    = fI[j] + fKi[j] * fE + fKt[j] * (fUk - fV);
+				fD[j]    = fDk;
+				fYOld[j] = fYs;
+
+				/* command and measurement of this sample */
+				fU[j] = fUk;
+				fY[j] = fYs / PREC;
+			}
+		}
+	}
+
+} // End: BatchStep()
+
+
+/**
+*  -------------------------------------------------------  *
+*  BATCHFREE() releases the memory of a batch.
+*
+*  Inputs:
+*     *Batch: pointer to the batch
+*  -------------------------------------------------------  *
+*/
+void BatchFree (BATCHSIM *Batch)
+{
+	free(Batch->pBlock);
+	Batch->pBlock    = NULL;
+	Batch->uNbrLoops = 0;
+	Batch->uStride   = 0;
+
+} // End: BatchFree()
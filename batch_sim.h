@@ -0,0 +1,40 @@
+#ifndef __BATCH_SIM_H__
+#define __BATCH_SIM_H__
+
+#include "control_system.h"
+
+#define BATCH_ALIGN    16    // array padding in floats (64 bytes, one AVX-512 register)
+#define BATCH_BLOCK    256   // loops advanced together to keep the state in L1 cache
+
+// N independent plant + PID loops in structure-of-arrays layout
+typedef struct tagBatchSim {
+	unsigned uNbrLoops;	// number of loops
+	unsigned uStride;		// padded length of every array
+	void    *pBlock;		// allocated memory block
+
+	/* set-points, in 1/PREC steps */
+	float *fR;
+
+	/* plant memory */
+	float *fY1, *fY2, *fY3;
+	float *fU1, *fU2, *fU3;
+
+	/* PID controller memory (fYOld in 1/PREC steps) */
+	float *fI, *fD, *fYOld;
+
+	/* PID controller coefficients */
+	float *fK, *fKd1, *fKd2, *fKi, *fKt;
+
+	/* last plant input and measured output */
+	float *fU, *fY;
+} BATCHSIM;
+
+int BatchInit (BATCHSIM *Batch, unsigned uNbrLoops);
+
+void BatchSetLoop (BATCHSIM *Batch, unsigned uLoop, const PIDSET *PID, float fSetpoint, float fTs);
+
+void BatchStep (BATCHSIM *Batch, unsigned uNbrIter);
+
+void BatchFree (BATCHSIM *Batch);
+
+#endif // __BATCH_SIM_H__
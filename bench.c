@@ -0,0 +1,461 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+
+#include "simulation.h"
+#include "control_system.h"
+#include "batch_sim.h"
+#include "data_treatment.h"
+#include "gnuplot_i.h"
+#include "util_func.h"
+
+#define BENCH_MAX_SAMPLES   100000000   // longest horizon of the compute stages
+#define BENCH_IO_SAMPLES    1000000     // longest horizon of the file stages
+#define BENCH_MIN_SAMPLES   1000        // shortest horizon (SIMTIME / SAMPLINGTIME)
+#define BENCH_REPEATS       5           // timed runs per stage and horizon
+#define BENCH_PATTERN       1024        // length of the periodic test signal
+#define BENCH_LOOPS         4096        // loops of the batch stage
+#define BENCH_FILE          "bench_data.dat"
+
+#ifdef WIN32
+#define BENCH_NULL_DEVICE   "NUL"
+#else
+#define BENCH_NULL_DEVICE   "/dev/null"
+#endif // #ifdef WIN32
+
+// one stage under test: returns the time of one run in sec
+typedef double (*STAGEFUNC)(unsigned uNbrSamples);
+
+typedef struct tagStage {
+	const char    *cName;
+	STAGEFUNC      Run;
+	unsigned char  bIO;	// stage touches files
+} STAGE;
+
+static short sSignal[BENCH_PATTERN];	// test signal around a set-point of 1
+
+static volatile double lfSink;			// keeps the timed loops alive
+
+
+/**
+*  -------------------------------------------------------  *
+*  SIGNALINIT() fills the periodic test signal: a sine of
+*  +-0.5 around 1 with a period of 10 sec.
+*  -------------------------------------------------------  *
+*/
+static void SignalInit (void)
+{
+	unsigned i;
+
+	for (i = 0; i < BENCH_PATTERN; i++)
+		sSignal[i] = (1 + 0.5 * sin(2 * pi * i * SAMPLINGTIME / 10)) * PREC;
+
+} // End: SignalInit()
+
+
+/**
+*  -------------------------------------------------------  *
+*  BENCHPLANT() times Sys2ndOrder().
+*  -------------------------------------------------------  *
+*/
+static double BenchPlant (unsigned uNbrSamples)
+{
+	PLANTSTATE Plant = PlantInit();
+
+	double lfStart, lfTime;
+
+	unsigned i;
+
+	long lSum = 0;
+
+	lfStart = WallClock();
+
+	for (i = 0; i < uNbrSamples; i++)
+		lSum += Sys2ndOrder(&Plant, sSignal[i % BENCH_PATTERN] - PREC);
+
+	lfTime = WallClock() - lfStart;
+
+	lfSink = lSum;
+
+	return lfTime;
+} // End: BenchPlant()
+
+
+/**
+*  -------------------------------------------------------  *
+*  BENCHPID() times PIDCtrl() with the tuned gains.
+*  -------------------------------------------------------  *
+*/
+static double BenchPID (unsigned uNbrSamples)
+{
+	PIDSTATE Ctrl = PIDInit();
+
+	PIDSET PID;
+
+	PIDCOEF Coef;
+
+	double lfStart, lfTime;
+
+	unsigned i;
+
+	long lSum = 0;
+
+	TunedPID(&PID);
+	Coef = PIDCompile(&PID, SAMPLINGTIME);
+
+	lfStart = WallClock();
+
+	for (i = 0; i < uNbrSamples; i++)
+		lSum += PIDCtrl(&Ctrl, &Coef, PREC, sSignal[i % BENCH_PATTERN]);
+
+	lfTime = WallClock() - lfStart;
+
+	lfSink = lSum;
+
+	return lfTime;
+} // End: BenchPID()
+
+
+/**
+*  -------------------------------------------------------  *
+*  BENCHAUTOTUNE() times AutoTune() on the oscillating te-
+*  st signal. The tuner restarts whenever it finishes.
+*  -------------------------------------------------------  *
+*/
+static double BenchAutoTune (unsigned uNbrSamples)
+{
+	TUNESTATE Tune = TuneInit();
+
+	PIDSET PID;
+
+	unsigned char bTuned = FALSE;
+
+	double lfStart, lfTime;
+
+	unsigned i;
+
+	long lSum = 0;
+
+	TunedPID(&PID);
+
+	lfStart = WallClock();
+
+	for (i = 0; i < uNbrSamples; i++)
+	{
+		lSum += AutoTune(&Tune, &bTuned, &PID, i * SAMPLINGTIME, PREC, sSignal[i % BENCH_PATTERN], SAMPLINGTIME);
+
+		if (bTuned)
+			bTuned = FALSE;
+	}
+
+	lfTime = WallClock() - lfStart;
+
+	lfSink = lSum + PID.K;
+
+	return lfTime;
+} // End: BenchAutoTune()
+
+
+/**
+*  -------------------------------------------------------  *
+*  BENCHLOOP() times LoopStep() on a MANUAL loop with the
+*  tuned gains (set-point 1).
+*  -------------------------------------------------------  *
+*/
+static double BenchLoop (unsigned uNbrSamples)
+{
+	SIMSET SimSet = SimInit(SIMTIME);
+
+	CASESET Case;
+
+	LOOP Loop;
+
+	double lfStart, lfTime;
+
+	unsigned i;
+
+	long lSum = 0;
+
+	Case.sSimCase   = MANUAL;
+	Case.sSetpoint  = PREC;
+	Case.fStepAmp   = 0;
+	Case.fStepDelay = 0;
+	Case.Plant      = NULL;
+	TunedPID(&Case.PID);
+
+	LoopInit(&Loop, &Case);
+
+	lfStart = WallClock();
+
+	for (i = 0; i < uNbrSamples; i++)
+	{
+		LoopStep(&Loop, &SimSet);
+		lSum += Loop.sSysOut;
+	}
+
+	lfTime = WallClock() - lfStart;
+
+	lfSink = lSum;
+
+	return lfTime;
+} // End: BenchLoop()
+
+
+/**
+*  -------------------------------------------------------  *
+*  BENCHBATCH() times BatchStep() on up to BENCH_LOOPS co-
+*  pies of the BenchLoop() loop. uNbrSamples counts loop
+*  samples, so the time per sample compares with Bench-
+*  Loop().
+*  -------------------------------------------------------  *
+*/
+static double BenchBatch (unsigned uNbrSamples)
+{
+	BATCHSIM Batch;
+
+	PIDSET PID;
+
+	double lfStart, lfTime;
+
+	unsigned j, uNbrLoops, uNbrIter;
+
+	uNbrLoops = min(BENCH_LOOPS, uNbrSamples);
+	uNbrIter  = uNbrSamples / uNbrLoops;
+
+	if (BatchInit(&Batch, uNbrLoops) != 0)
+		return 0;
+
+	TunedPID(&PID);
+
+	for (j = 0; j < uNbrLoops; j++)
+		BatchSetLoop(&Batch, j, &PID, 1, SAMPLINGTIME);
+
+	lfStart = WallClock();
+
+	BatchStep(&Batch, uNbrIter);
+
+	lfTime = WallClock() - lfStart;
+
+	lfSink = Batch.fY[uNbrLoops - 1];
+
+	BatchFree(&Batch);
+
+	/* time of uNbrSamples loop samples */
+	return lfTime * uNbrSamples / ((double)uNbrLoops * uNbrIter);
+} // End: BenchBatch()
+
+
+/**
+*  -------------------------------------------------------  *
+*  BENCHSAVEDATA() times writing a log with SaveData(),
+*  from LogOpen() to LogClose(). The log is left for
+*  BenchReadData().
+*  -------------------------------------------------------  *
+*/
+static double BenchSaveData (unsigned uNbrSamples)
+{
+	const char *cChanNames[3] = {"time", "input", "output"};
+
+	LOGFILE *Log;
+
+	double lfStart, lfTime;
+
+	unsigned i;
+
+	lfStart = WallClock();
+
+	Log = LogOpen(BENCH_FILE, SAMPLINGTIME, uNbrSamples, 3, cChanNames);
+	if (Log == NULL)
+		return 0;
+
+	for (i = 0; i < uNbrSamples; i++)
+		SaveData(Log, i * SAMPLINGTIME, sSignal[i % BENCH_PATTERN] - PREC, sSignal[i % BENCH_PATTERN]);
+
+	LogClose(Log);
+
+	lfTime = WallClock() - lfStart;
+
+	return lfTime;
+} // End: BenchSaveData()
+
+
+/**
+*  -------------------------------------------------------  *
+*  BENCHREADDATA() times ReadIOData() of the log left by
+*  BenchSaveData(), including one pass over the samples.
+*  -------------------------------------------------------  *
+*/
+static double BenchReadData (unsigned uNbrSamples)
+{
+	DATASET DataSet;
+
+	double lfStart, lfTime, lfSum = 0;
+
+	unsigned i, uLength;
+
+	lfStart = WallClock();
+
+	DataSet = ReadIOData(BENCH_FILE);
+	uLength = DataSet.Length;
+
+	for (i = 0; i < DataSet.Length; i++)
+		lfSum += DataSet.Input[i] + DataSet.Output[i];
+
+	FreeIOData(&DataSet);
+
+	lfTime = WallClock() - lfStart;
+
+	if (uLength != uNbrSamples)
+		puts("Error: benchmark log has a wrong length!\n");
+
+	lfSink = lfSum;
+
+	return lfTime;
+} // End: BenchReadData()
+
+
+/**
+*  -------------------------------------------------------  *
+*  BENCHPLOT() times the temporary file path of gnuplot_
+*  plot_xy(). The commands go to a null device instead of
+*  a gnuplot process, so only the data transfer is timed.
+*  -------------------------------------------------------  *
+*/
+static double BenchPlot (unsigned uNbrSamples, int iBinary)
+{
+	gnuplot_ctrl Handle;
+
+	double *lfX, *lfY, lfStart, lfTime;
+
+	unsigned i;
+
+	lfX = malloc(sizeof(double) * uNbrSamples);
+	lfY = malloc(sizeof(double) * uNbrSamples);
+
+	memset(&Handle, 0, sizeof(Handle));
+	Handle.gnucmd = fopen(BENCH_NULL_DEVICE, "w");
+
+	if (lfX == NULL || lfY == NULL || Handle.gnucmd == NULL)
+	{
+		puts("Error: benchmark plot setup failed!\n");
+		free(lfX);
+		free(lfY);
+		return 0;
+	}
+
+	gnuplot_setstyle(&Handle, "lines");
+	gnuplot_setbinary(&Handle, iBinary);
+
+	for (i = 0; i < uNbrSamples; i++)
+	{
+		lfX[i] = i * SAMPLINGTIME;
+		lfY[i] = (double)sSignal[i % BENCH_PATTERN] / PREC;
+	}
+
+	lfStart = WallClock();
+
+	gnuplot_plot_xy(&Handle, lfX, lfY, uNbrSamples, "bench");
+	fflush(Handle.gnucmd);
+
+	lfTime = WallClock() - lfStart;
+
+	/* what gnuplot_close() does for a real session */
+	gnuplot_remove_tmpfiles(&Handle);
+
+	fclose(Handle.gnucmd);
+	free(lfX);
+	free(lfY);
+
+	return lfTime;
+} // End: BenchPlot()
+
+static double BenchPlotText (unsigned uNbrSamples)
+{
+	return BenchPlot(uNbrSamples, 0);
+} // End: BenchPlotText()
+
+static double BenchPlotBinary (unsigned uNbrSamples)
+{
+	return BenchPlot(uNbrSamples, 1);
+} // End: BenchPlotBinary()
+
+
+/**
+*  -------------------------------------------------------  *
+*  Benchmark of the simulation stages. Every stage runs
+*  once untimed and BENCH_REPEATS times timed per horizon;
+*  the mean and standard deviation of the time per sample
+*  are reported.
+*
+*  Usage: Auto_Tuning_bench [max_samples [max_io_samples
+*         [repeats]]]
+*  -------------------------------------------------------  *
+*/
+int main (int argc, char *argv[])
+{
+	const STAGE Stages[] = {
+		{"Sys2ndOrder"   , BenchPlant     , FALSE},
+		{"PIDCtrl"       , BenchPID       , FALSE},
+		{"AutoTune"      , BenchAutoTune  , FALSE},
+		{"LoopStep"      , BenchLoop      , FALSE},
+		{"BatchStep"     , BenchBatch     , FALSE},
+		{"SaveData"      , BenchSaveData  , TRUE },
+		{"ReadIOData"    , BenchReadData  , TRUE },
+		{"plot_xy text"  , BenchPlotText  , TRUE },
+		{"plot_xy binary", BenchPlotBinary, TRUE }
+	};
+
+	unsigned uNbrStages = sizeof(Stages) / sizeof(Stages[0]);
+
+	unsigned uMaxSamples = BENCH_MAX_SAMPLES, uMaxIOSamples = BENCH_IO_SAMPLES, uNbrRepeats = BENCH_REPEATS;
+
+	unsigned i, j, n;
+
+	double lfNs, lfMean, lfSq, lfStd;
+
+	if (argc > 1)
+		uMaxSamples   = atof(argv[1]);
+	if (argc > 2)
+		uMaxIOSamples = atof(argv[2]);
+	if (argc > 3)
+		uNbrRepeats   = max(atoi(argv[3]), 1);
+
+	SignalInit();
+
+	printf("%-16s %10s %12s %12s %14s\n", "stage", "samples", "ns/sample", "std", "samples/sec");
+
+	for (i = 0; i < uNbrStages; i++)
+	{
+		for (n = BENCH_MIN_SAMPLES; n <= (Stages[i].bIO ? uMaxIOSamples : uMaxSamples); n *= 10)
+		{
+			/* ReadIOData() needs the log of the same horizon */
+			if (Stages[i].Run == BenchReadData)
+				BenchSaveData(n);
+
+			Stages[i].Run(n);	// warm-up
+
+			lfMean = lfSq = 0;
+
+			for (j = 0; j < uNbrRepeats; j++)
+			{
+				lfNs    = Stages[i].Run(n) * 1e9 / n;
+				lfMean += lfNs;
+				lfSq   += lfNs * lfNs;
+			}
+
+			lfMean /= uNbrRepeats;
+			lfStd   = (uNbrRepeats > 1) ? sqrt(max((lfSq - uNbrRepeats * lfMean * lfMean) / (uNbrRepeats - 1), 0)) : 0;
+
+			printf("%-16s %10u %12.2f %12.2f %14.4g\n", Stages[i].cName, n, lfMean, lfStd, 1e9 / lfMean);
+
+			if (n > UINT_MAX / 10)
+				break;
+		}
+	}
+
+	remove(BENCH_FILE);
+
+	return 0;
+} // End: main()
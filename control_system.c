@@ -2,21 +2,121 @@
 #include <math.h>
 
 #include "control_system.h"
+#include "tune_rules.h"
 #include "simulation.h"
 #include "util_func.h"
 
 
 /**
 *  -------------------------------------------------------  *
-*  PIDCTRL() is the PID controller.
+*  PIDINIT() initializes the memory of a PID controller.
+*
+*  Outputs:
+*     Ctrl: cleared PID controller state
+*  -------------------------------------------------------  *
+*/
+PIDSTATE PIDInit (void)
+{
+	PIDSTATE Ctrl;
+	
+	Ctrl.fIOld = 0;
+	Ctrl.fDOld = 0;
+	Ctrl.sYOld = 0;
+	Ctrl.fEOld = 0;
+	Ctrl.fP    = 0;
+	Ctrl.fI    = 0;
+	Ctrl.fD    = 0;
+	
+	return Ctrl;
+} // End: PIDInit()
+
+
+/**
+*  -------------------------------------------------------  *
+*  PIDCOMPILE() derives the per-sample constants of the P-
+*  ID controller from its gains. It has to be called only
+*  when the gains or the sampling time change.
 *
 *  Inputs:
 *     *PID: pointer to a PID structure
-*     sR  : setpoint (reference)
-*     sY  : plant output
 *     fTs : sampling time
 *
 *  Outputs:
+*     Coef: controller constants for PIDCtrl()
+*  -------------------------------------------------------  *
+*/
+PIDCOEF PIDCompile (const PIDSET *PID, float fTs)
+{
+	PIDCOEF Coef;
+	
+	float fTt;
+	
+	Coef.fK = PID->K;
+	
+	/* derivative params */
+	if (PID->Td + PID->N * fTs > 0)
+		Coef.fKd1 = PID->Td / (PID->Td + PID->N * fTs);
+	else
+		Coef.fKd1 = 0;
+	
+	Coef.fKd2 = Coef.fKd1 * PID->K * PID->N;
+	
+	/* integrator params */
+	Coef.fKi = PID->K * fTs / (PID->Ti);				// integrator gain
+	
+	/* anti-windup params */
+	if (PID->Td > 0.1 * PID->Ti)
+		fTt = sqrt((double)(PID->Ti * PID->Td));	// anti-windup time
+	else
+		fTt = 0.3 * PID->Ti;							// anti-windup time
+	
+	Coef.fKt = fTs / fTt;								// anti-windup gain
+	
+	return Coef;
+} // End: PIDCompile()
+
+
+/**
+*  -------------------------------------------------------  *
+*  PIDRETUNE() changes the gains of a running PID control-
+*  ler without a bump in the control command. The integ-
+*  rator absorbs the change of the proportional part, so
+*  the next command is the same as with the old gains for
+*  an unchanged error.
+*
+*  Inputs:
+*     *Ctrl: pointer to the PID controller state
+*     *Coef: pointer to the compiled constants in use
+*     *PID : pointer to the new PID structure
+*     fTs  : sampling time
+*
+*  Outputs:
+*     *Ctrl, *Coef: updated for the new gains
+*  -------------------------------------------------------  *
+*/
+void PIDRetune (PIDSTATE *Ctrl, PIDCOEF *Coef, const PIDSET *PID, float fTs)
+{
+	float fKOld = Coef->fK;
+	
+	*Coef = PIDCompile(PID, fTs);
+	
+	Ctrl->fIOld += (fKOld - Coef->fK) * Ctrl->fEOld;
+	
+} // End: PIDRetune()
+
+
+/**
+*  -------------------------------------------------------  *
+*  PIDCTRL() is the PID controller. The constants come
+*  from PIDCompile(), so a sample costs only multiply-adds.
+*
+*  Inputs:
+*     *Ctrl: pointer to the PID controller state
+*     *Coef: pointer to the compiled PID constants
+*     sR   : setpoint (reference)
+*     sY   : plant output
+*
+*  Outputs:
 *     sU: controll command
 *
 *  Author: S. Ehsan Shafiei
@@ -24,49 +124,30 @@
 *  -------------------------------------------------------  *
 */
 short PIDCtrl (
-		   unsigned char  bReset,
-		   const PIDSET *PID, 
+		   PIDSTATE *Ctrl,
+		   const PIDCOEF *Coef, 
 			short sR, 
-			short sY, 
-			float fTs
+			short sY
 			)
 {
-	float fError, fDY, fY, fV;
+	float fError, fDY, fV;
 	
 	float fP, fI, fD;
 	
 	short sU;
 	
-	float fKd1, fKd2, fKi, fKt, fTt;
-	
-	static float fIOld, fDOld;
-	
-	static short sYOld;
-	
-	/* reset static variables for the next simulation */
-	if (bReset)
-	{
-	   fIOld = 0;
-		fDOld = 0;
-		sYOld = 0;
-	}
-	
 	/* floating point error signal */
    fError = (float)(sR - sY) / PREC;
 
    /* proportional part */
-   fP = PID->K * fError;
-   
-   /* derivative params */
-   fKd1 = PID->Td / (PID->Td + PID->N * fTs);
-   fKd2 = fKd1 * PID->K * PID->N;
+   fP = Coef->fK * fError;
 		
    /* integral part */
-   fI = fIOld;
+   fI = Ctrl->fIOld;
    
 	/* derivative parts */
-   fDY = (float)(sY - sYOld) / PREC;	// floating point output difference
-   fD  = fKd1 * fDOld - fKd2 * fDY;
+   fDY = (float)(sY - Ctrl->sYOld) / PREC;	// floating point output difference
+   fD  = Coef->fKd1 * Ctrl->fDOld - Coef->fKd2 * fDY;
 
    /* paralle PID */
    fV = fP + fI + fD;
@@ -74,48 +155,263 @@ short PIDCtrl (
    
    /* saturation filter */
    sU = sat(sU, UMIN * PREC, UMAX * PREC);
-   
-   /* integrator params */
-   fKi = PID->K * fTs / (PID->Ti);					// integrator gain
-   
-   /* anti-windup params */
-   if (PID->Td > 0.1 * PID->Ti)
-   	fTt = sqrt((double)(PID->Ti * PID->Td));	// anti-windup time
-  	else
-  		 fTt = 0.3 * PID->Ti;							// anti-windup time
-   
-	fKt = fTs / fTt;										// anti-windup gain
 
    /* updates */
-   fIOld = fI + fKi * fError + fKt * ((float)sU / PREC - fV);	// integrator update including anti-windup
-   sYOld = sY;
-   fDOld = fD;
+   Ctrl->fIOld = fI + Coef->fKi * fError + Coef->fKt * ((float)sU / PREC - fV);	// integrator update including anti-windup
+   Ctrl->sYOld = sY;
+   Ctrl->fDOld = fD;
+   Ctrl->fEOld = fError;
+   
+   /* contributions kept for logging */
+   Ctrl->fP = fP;
+   Ctrl->fI = fI;
+   Ctrl->fD = fD;
    
 	return sU;
    
 } // End: PIDCtrl()
 
 
+/**
+*  -------------------------------------------------------  *
+*  TUNEDFTSTART() clears the single-bin DFT for the next
+*  oscillation period. The bin is at the frequency of the
+*  period that just ended, the phasor being rotated once
+*  per sample (a Goertzel-like oscillator, no table and no
+*  buffer).
+*
+*  Inputs:
+*     *Tune  : pointer to the relay tuner state
+*     fPeriod: frequency of the bin as a period (0: none)
+*     fTs    : sampling time
+*  -------------------------------------------------------  *
+*/
+static void TuneDftStart (TUNESTATE *Tune, float fPeriod, float fTs)
+{
+	Tune->fRotC = (fPeriod > 0) ? cos(2 * pi * fTs / fPeriod) : 0;
+	Tune->fRotS = (fPeriod > 0) ? sin(2 * pi * fTs / fPeriod) : 0;
+	Tune->fCos  = 1;
+	Tune->fSin  = 0;
+	
+	Tune->fSumE = Tune->fSumEC = Tune->fSumES = 0;
+	Tune->fSumU = Tune->fSumUC = Tune->fSumUS = 0;
+	Tune->fSumC = Tune->fSumS  = 0;
+	Tune->uNbrSamples = 0;
+	
+} // End: TuneDftStart()
+
+
+/**
+*  -------------------------------------------------------  *
+*  TUNEDFTADD() adds one sample of the error and the relay
+*  output to the DFT sums.
+*  -------------------------------------------------------  *
+*/
+static void TuneDftAdd (TUNESTATE *Tune, float fError, float fU)
+{
+	float fCos;
+	
+	Tune->fSumE  += fError;
+	Tune->fSumEC += fError * Tune->fCos;
+	Tune->fSumES += fError * Tune->fSin;
+	Tune->fSumU  += fU;
+	Tune->fSumUC += fU * Tune->fCos;
+	Tune->fSumUS += fU * Tune->fSin;
+	Tune->fSumC  += Tune->fCos;
+	Tune->fSumS  += Tune->fSin;
+	Tune->uNbrSamples++;
+	
+	fCos       = Tune->fCos * Tune->fRotC - Tune->fSin * Tune->fRotS;
+	Tune->fSin = Tune->fSin * Tune->fRotC + Tune->fCos * Tune->fRotS;
+	Tune->fCos = fCos;
+	
+} // End: TuneDftAdd()
+
+
+/**
+*  -------------------------------------------------------  *
+*  TUNEDFTGAIN() estimates the critical gain from the fun-
+*  damentals of the error E and the relay output U over
+*  one period. The means are removed first, so the relay
+*  bias does not leak into the bin. With y = r - e, the
+*  plant at the oscillation frequency is G = -E/U and
+*
+*     Ku = -1 / Re(G) = |U|^2 / Re(E conj(U))
+*
+*  which is the describing function result 4d/(pi sqrt(a^2
+*  - eps^2)) of a relay with hysteresis, without its sine
+*  wave assumption.
+*
+*  Outputs:
+*     fKu: critical gain, 0 if there is no estimate
+*  -------------------------------------------------------  *
+*/
+static float TuneDftGain (const TUNESTATE *Tune)
+{
+	float fMeanE, fMeanU, fEc, fEs, fUc, fUs, fDen;
+	
+	if (Tune->uNbrSamples == 0 || (Tune->fRotC == 0 && Tune->fRotS == 0))
+		return 0;
+	
+	fMeanE = Tune->fSumE / Tune->uNbrSamples;
+	fMeanU = Tune->fSumU / Tune->uNbrSamples;
+	
+	fEc = Tune->fSumEC - fMeanE * Tune->fSumC;
+	fEs = Tune->fSumES - fMeanE * Tune->fSumS;
+	fUc = Tune->fSumUC - fMeanU * Tune->fSumC;
+	fUs = Tune->fSumUS - fMeanU * Tune->fSumS;
+	
+	fDen = fEc * fUc + fEs * fUs;
+	
+	if (fDen <= 0)
+		return 0;
+	
+	return (fUc * fUc + fUs * fUs) / fDen;
+} // End: TuneDftGain()
+
+
+/**
+*  -------------------------------------------------------  *
+*  TUNEDFTSTATICGAIN() estimates the static gain of the
+*  plant from the means of the output and the relay out-
+*  put over one period (a biased relay has a non-zero
+*  mean input). The plant is assumed at rest at zero be-
+*  fore the experiment.
+*
+*  Inputs:
+*     *Tune: pointer to the relay tuner state
+*     fR   : set-point
+*
+*  Outputs:
+*     fGain: static gain, 0 if the mean input is zero
+*  -------------------------------------------------------  *
+*/
+static float TuneDftStaticGain (const TUNESTATE *Tune, float fR)
+{
+	float fMeanU;
+	
+	if (Tune->uNbrSamples == 0)
+		return 0;
+	
+	fMeanU = Tune->fSumU / Tune->uNbrSamples;
+	
+	if (fabs(fMeanU) < 0.01 * (UMAX - UMIN))
+		return 0;
+	
+	return (fR - Tune->fSumE / Tune->uNbrSamples) / fMeanU;
+} // End: TuneDftStaticGain()
+
+
+/**
+*  -------------------------------------------------------  *
+*  TUNEWINDOWSTAT() returns the mean of the last (up to
+*  TUNEWINDOW) estimates and the 95% confidence half-width
+*  of that mean (Student t). The first periods of an os-
+*  cillation are still settling, so older estimates are
+*  left out.
+*
+*  Inputs:
+*     *fEst: ring of the last estimates
+*     sNbr : number of estimates so far
+*
+*  Outputs:
+*     *fMean: mean of the window
+*     fCi   : confidence half-width (HUGE_VAL below two)
+*  -------------------------------------------------------  *
+*/
+static float TuneWindowStat (const float *fEst, short sNbr, float *fMean)
+{
+	static const float fStudent[] = {0, 12.71, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262};
+	
+	float fVar = 0;
+	
+	short i, n;
+	
+	n = min(sNbr, TUNEWINDOW);
+	
+	for (i = 0, *fMean = 0; i < n; i++)
+		*fMean += fEst[i] / n;
+	
+	if (n < 2)
+		return HUGE_VAL;
+	
+	for (i = 0; i < n; i++)
+		fVar += (fEst[i] - *fMean) * (fEst[i] - *fMean) / (n - 1);
+	
+	return ((n - 1 < 10) ? fStudent[n - 1] : 2.228) * sqrt(fVar / n);
+} // End: TuneWindowStat()
+
+
+/**
+*  -------------------------------------------------------  *
+*  TUNEINIT() initializes the memory of the relay auto-
+*  tuner.
+*
+*  Outputs:
+*     Tune: relay tuner state ready for a new experiment
+*  -------------------------------------------------------  *
+*/
+TUNESTATE TuneInit (void)
+{
+	TUNESTATE Tune;
+	
+	Tune.bOscillation = 0;
+	Tune.fTimeOld     = 0;
+	Tune.fTup         = 0;
+	Tune.fTdown       = 0;
+	Tune.fUb          = 0.5 * (UMIN + UMAX);
+	Tune.sPerCount    = 0;
+	Tune.sUOld        = UMAX * PREC;
+	Tune.Relay.fKu         = 0;
+	Tune.Relay.fPu         = 0;
+	Tune.Relay.fKuCi       = 0;
+	Tune.Relay.fPuCi       = 0;
+	Tune.Relay.fBias       = 0;
+	Tune.Relay.fAmplitude  = 0;
+	Tune.Relay.fHysteresis = 0;
+	Tune.Relay.fGain       = 0;
+	Tune.sNbrEst      = 0;
+	
+	TuneDftStart(&Tune, 0, 0);
+	
+	return Tune;
+} // End: TuneInit()
+
+
+
 /**
 *  -------------------------------------------------------  *
 *  AUTOTUNE() automatically tunes a PID controller gains 
 *  using a relay feedback method. A biased relay is used 
 *  where the bias value is adjusted automatically.
+*  Once the oscillation is steady, the critical gain of
+*  every period is estimated online from the fundamentals
+*  of the error and the relay output (see TuneDftGain()),
+*  and the tuning ends as soon as the 95% confidence in-
+*  tervals of the mean Ku and Pu of the last TUNEWINDOW
+*  periods are within TUNECONFTOL, after MAXPERIODS peri-
+*  ods at the latest. If no period gave an estimate by
+*  then, the tuning ends with a zero Ku and the PID gains
+*  are left as they were.
 *
 *  Inputs:
-*     *PID: pointer to a PID structure
-*     sR  : setpoint (reference)
-*     sY  : plant output
-*     fTs : sampling time
+*     *Tune: pointer to the relay tuner state
+*     *PID : pointer to a PID structure
+*     sR   : setpoint (reference)
+*     sY   : plant output
+*     fTs  : sampling time
 *
 *  Outputs:
 *     sU: controll command
+*     Tune->Relay: critical point and relay settings once
+*                  tuned
 *
 *  Author: S. Ehsan Shafiei
 *          Jul. 2015
 *  -------------------------------------------------------  *
 */
 short AutoTune (
+		   TUNESTATE *Tune,
 		   unsigned char *bTuned, 
 			PIDSET *PID, 
 			float fTime, 
@@ -124,20 +420,16 @@ short AutoTune (
 			float fTs
 			)
 {
-   float fTimeOld, fError, fDeltaU, fDeltaError, fKu, fPu, fUn;
-   
-   static char ErrorSignOld;
-   
-   static unsigned char bOscillation = 0;
-   
-   static float fTup, fTdown, fErrorOld, fErrorMax, fUb = 0.5 * (UMIN + UMAX);
-   
-   static short sPerCount, sUOld = UMAX * PREC;
+   float fError, fDeltaU, fDeltaError, fKu, fPu, fUn;
+	
+	RELAYRESULT Relay;
 	
 	short sU;
    
    #define DELTAERROR   2    // error hysteresis bound in percent
 	#define PERIODDIF    10   // difference between half perios oscillations
+	#define MAXPERIODS   6    // oscillation periods after which the tuning ends
+	#define TUNECONFTOL  5    // confidence half-width in percent of the estimate
    
    /* hysteresis bound for error */
    fDeltaError = (float)abs(sR) * DELTAERROR / PREC / 100;
@@ -146,83 +438,106 @@ short AutoTune (
 	fError = (float)(sR - sY)/ PREC;
 
    /* bias limits */
-   fUb 	  = sat(fUb, UMIN, UMAX);
-   fDeltaU = min((UMAX - fUb), (fUb - UMIN));
+   Tune->fUb = sat(Tune->fUb, UMIN, UMAX);
+   fDeltaU   = min((UMAX - Tune->fUb), (Tune->fUb - UMIN));
    
    /* relay actions */
-	if ((fError < -fDeltaError) && (sUOld > fUb * PREC))
+	if ((fError < -fDeltaError) && (Tune->sUOld > Tune->fUb * PREC))
    {
-   	fTup = fTime - fTimeOld;	// update the time of high relay
-   	fTimeOld = fTime;
+   	Tune->fTup = fTime - Tune->fTimeOld;	// update the time of high relay
+   	Tune->fTimeOld = fTime;
    	
-   	sU = (fUb - fDeltaU) * PREC;
-   	sUOld = sU;
+   	sU = (Tune->fUb - fDeltaU) * PREC;
+   	Tune->sUOld = sU;
    }
-   else if ((fError > fDeltaError) && (sUOld < fUb * PREC))
+   else if ((fError > fDeltaError) && (Tune->sUOld < Tune->fUb * PREC))
    {
-   	fTdown = fTime - fTimeOld;	// update the time of high relay
-   	fTimeOld = fTime;
+   	Tune->fTdown = fTime - Tune->fTimeOld;	// update the time of high relay
+   	Tune->fTimeOld = fTime;
    	
-		sU = (fUb + fDeltaU) * PREC;
-   	sUOld = sU;
+		sU = (Tune->fUb + fDeltaU) * PREC;
+   	Tune->sUOld = sU;
    	
    	/* ckeck if the half periods differ more than 10% */
-   	if (fabs(fTup - fTdown) * 100 / (fTup + fTdown) > PERIODDIF)
+   	if (fabs(Tune->fTup - Tune->fTdown) * 100 / (Tune->fTup + Tune->fTdown) > PERIODDIF)
    	{
-   		bOscillation = 0;
+   		Tune->bOscillation = 0;
+   		Tune->sNbrEst      = 0;	// estimates of another oscillation
       	
 			/* bias value in hysteresis relay in case of biased relay.
 			   fUb has to be normalized (e.g. to [0 100]); otherwise it
 			   cannot be updated if initialized to zero. It can happen
 			   in case of a symmetric input limits. */
-			fUn = (fUb - UMIN) * 100 / (UMAX - UMIN);	// normalized to [0 100]
-         fUn = fUn * (1 + (fTup - fTdown) / 2 / (fTup + fTdown));
-         fUb = fUn * (UMAX - UMIN) / 100 + UMIN;			
+			fUn = (Tune->fUb - UMIN) * 100 / (UMAX - UMIN);	// normalized to [0 100]
+         fUn = fUn * (1 + (Tune->fTup - Tune->fTdown) / 2 / (Tune->fTup + Tune->fTdown));
+         Tune->fUb = fUn * (UMAX - UMIN) / 100 + UMIN;			
 		}
 		else
 		{
-			bOscillation = 1;   // oscillation starts at critical freq
-         sPerCount ++;		  // number of oscillation half-periods
+			Tune->bOscillation = 1;   // oscillation starts at critical freq
+         Tune->sPerCount ++;		  // number of oscillation periods
       	
-      	/* check if there are "enough" oscillations 
+      	/* critical point of the period that just ended */
+      	fKu = TuneDftGain(Tune);
+      	fPu = Tune->fTup + Tune->fTdown;
+      	
+      	if (fKu > 0)
+      	{
+      		Tune->fKuEst[Tune->sNbrEst % TUNEWINDOW] = fKu;
+      		Tune->fPuEst[Tune->sNbrEst % TUNEWINDOW] = fPu;
+      		Tune->sNbrEst++;
+      		
+      		Tune->Relay.fKuCi = TuneWindowStat(Tune->fKuEst, Tune->sNbrEst, &Tune->Relay.fKu);
+      		Tune->Relay.fPuCi = TuneWindowStat(Tune->fPuEst, Tune->sNbrEst, &Tune->Relay.fPu);
+      		
+      		Tune->Relay.fBias       = Tune->fUb;
+      		Tune->Relay.fAmplitude  = fDeltaU;
+      		Tune->Relay.fHysteresis = fDeltaError;
+      		Tune->Relay.fGain       = TuneDftStaticGain(Tune, (float)sR / PREC);
+      	}
+      	
+      	/* check if the estimates are "good enough" 
 			*  to conclude the tuning  */
-		   if (sPerCount > 5)
+		   if (Tune->sPerCount >= MAXPERIODS || (Tune->sNbrEst >= TUNEWINDOW
+		       && Tune->Relay.fKuCi * 100 <= TUNECONFTOL * Tune->Relay.fKu
+		       && Tune->Relay.fPuCi * 100 <= TUNECONFTOL * Tune->Relay.fPu))
 		   {
 		   	*bTuned = TRUE;
 
-				/* tune the PID gains (Ziegler-Nichols) */
-		   	fKu = 4 * fDeltaU / (pi * sqrt((double)(fErrorMax * fErrorMax - fDeltaError * fDeltaError)));
-		   	fPu = fTup + fTdown;
-		   	
-		   	PID->K  = 0.6   * fKu;   // proportional gain
-			   PID->Ti = 0.5   * fPu;   // integration time
-			   PID->Td = 0.125 * fPu;	 // derivative time
-			   PID->N  = 100;
+				if (Tune->sNbrEst > 0)
+				{
+					/* tune the PID gains (Ziegler-Nichols) */
+			   	RuleZieglerNichols(&Tune->Relay, PID);
+				}
+				else
+				{
+					/* no period gave a critical gain: keep the gains */
+					Tune->Relay.fKu = 0;
+					Tune->Relay.fPu = 0;
+					
+					puts("Error: no critical gain from the relay experiment, the PID gains are kept!\n");
+				}
 			}			   
 		}
+		
+		/* next period is analyzed at the frequency of this one */
+		TuneDftStart(Tune, Tune->fTup + Tune->fTdown, fTs);
 	}
 	else
 	{
-		sU = sUOld;
+		sU = Tune->sUOld;
 	}
    
-   /* calculate the maximum amplitude of variation */
-   if (bOscillation)
-   {
-      if (fabs(fError) > fabs(fErrorOld))
-         fErrorMax = fabs(fError);
-      
-      fErrorOld = fError;
-   }
+   TuneDftAdd(Tune, fError, (float)sU / PREC);
 	
-	/* reset static variables for the next simulation */
+	/* reset the tuner for the next experiment, keeping its result */
 	if (*bTuned)
 	{
-		bOscillation = 0;
-   	fErrorMax    = 0;
-		fUb          = 0.5 * (UMIN + UMAX);
-   	sPerCount    = 0;
-		sUOld        = UMAX * PREC;
+		Relay = Tune->Relay;
+		
+		*Tune = TuneInit();
+		
+		Tune->Relay = Relay;
 	}
 	
 	return sU;
@@ -298,7 +613,9 @@ void SetPIDParam (PIDSET *PID)
 *  STEP() applies step input to a system.
 *
 *  Inputs:
-*     fT: current time instant
+*     fT        : current time instant
+*     fStepAmp  : step size
+*     fStepDelay: step delay [sec]
 *
 *  Output:
 *     sStep: step input command
@@ -307,53 +624,56 @@ void SetPIDParam (PIDSET *PID)
 *          Jul. 2015
 *  -------------------------------------------------------  *
 */
-short step(float fT)
+short step(float fT, float fStepAmp, float fStepDelay)
 {
 	short sU;
-	static float fStepAmp, fStepDelay;
-	static unsigned char bRead = TRUE;
-	
-	if (bRead)
-	{
-		printf("Enter step size:\n");
-		scanf("%f", &fStepAmp);
-		fflush(stdin);
-		
-		if (fStepAmp < UMIN || fStepAmp > UMAX)
-			printf("Warning: system input is limited to [%2.2f %2.2f]!\n", (float)UMIN, (float)UMAX);
-			
-		printf("Enter step delay [sec]:\n");
-		scanf("%f", &fStepDelay);
-		fflush(stdin);
-		
-		if (fStepDelay < 0)
-		{
-			fStepDelay = 0;
-			puts("Warning: a minimum step delay equals to zero has been assined.\n");
-		}
-		else if (fStepDelay > SIMTIME - SAMPLINGTIME)
-		{
-			fStepDelay = SIMTIME - 3 * SAMPLINGTIME;
-			puts("Warning: step delay is larger than the simulation time.\n");	
-		}
-		
-		bRead = FALSE;
-	}
 	
 	if (fT > fStepDelay)
 		sU = fStepAmp * PREC;
 	else
 		sU = 0 * PREC;		
 	
-	/* reset bRead value for the next simulation */
-	if (fT >= SIMTIME - SAMPLINGTIME)
-		bRead = TRUE;
-	
 	return sU;
 	
 } // End: step()
 
 
+/**
+*  -------------------------------------------------------  *
+*  GETSTEPPARAM() gets the step size and delay from user.
+*
+*  Outputs:
+*     *fStepAmp  : step size
+*     *fStepDelay: step delay [sec]
+*  -------------------------------------------------------  *
+*/
+void GetStepParam(float *fStepAmp, float *fStepDelay)
+{
+	printf("Enter step size:\n");
+	scanf("%f", fStepAmp);
+	fflush(stdin);
+	
+	if (*fStepAmp < UMIN || *fStepAmp > UMAX)
+		printf("Warning: system input is limited to [%2.2f %2.2f]!\n", (float)UMIN, (float)UMAX);
+		
+	printf("Enter step delay [sec]:\n");
+	scanf("%f", fStepDelay);
+	fflush(stdin);
+	
+	if (*fStepDelay < 0)
+	{
+		*fStepDelay = 0;
+		puts("Warning: a minimum step delay equals to zero has been assined.\n");
+	}
+	else if (*fStepDelay > SIMTIME - SAMPLINGTIME)
+	{
+		*fStepDelay = SIMTIME - 3 * SAMPLINGTIME;
+		puts("Warning: step delay is larger than the simulation time.\n");	
+	}
+	
+} // End: GetStepParam()
+
+
 /**
 *  -------------------------------------------------------  *
 *  GETSETPOINT() gets a set-popint value from user.
@@ -1,6 +1,8 @@
 #ifndef __CONTROL_SYSTEM_H__
 #define __CONTROL_SYSTEM_H__
 
+#define TUNEWINDOW   3   // last critical point estimates averaged by the relay tuner
+
 
 // PID gains for ideal form implementation
 typedef struct tagPIDSET
@@ -11,11 +13,76 @@ typedef struct tagPIDSET
 	short N ;		// derivative filter factor	
 } PIDSET;
 
-short step(float fT);
+// PID constants derived once from the gains (see PIDCompile())
+typedef struct tagPIDCoef
+{
+	float fK;			// proportional gain
+	float fKd1, fKd2;	// derivative filter pole and gain
+	float fKi;			// integrator gain
+	float fKt;			// anti-windup gain
+} PIDCOEF;
+
+// PID controller memory (one per control loop)
+typedef struct tagPIDState
+{
+	float fIOld;	// integral part of the previous sample
+	float fDOld;	// derivative part of the previous sample
+	short sYOld;	// plant output of the previous sample
+	float fEOld;	// error of the previous sample
+	float fP, fI, fD;	// contributions of the last sample
+} PIDSTATE;
+
+// outcome of a relay experiment, the input of the tuning rules (tune_rules.h)
+typedef struct tagRelayResult
+{
+	float fKu, fPu;			// critical gain and period
+	float fKuCi, fPuCi;		// 95% confidence half-widths of fKu and fPu
+	float fBias;				// relay bias
+	float fAmplitude;		// relay amplitude around the bias
+	float fHysteresis;		// error hysteresis of the relay
+	float fGain;				// static gain of the plant, 0 if unknown
+} RELAYRESULT;
+
+// relay auto-tuner memory (one per control loop)
+typedef struct tagTuneState
+{
+	unsigned char bOscillation;	// oscillation at the critical frequency
+	float fTimeOld;				// time of the last relay switch
+	float fTup, fTdown;			// high and low relay half periods
+	float fUb;						// relay bias
+	short sPerCount;				// number of oscillation periods
+	short sUOld;					// previous relay output
+	RELAYRESULT Relay;			// critical point (online estimate, then result)
+
+	/* single-bin DFT of the current period at the last frequency */
+	float    fRotC, fRotS;		// phasor rotation per sample, 0 if no frequency yet
+	float    fCos, fSin;		// phasor
+	float    fSumE, fSumEC, fSumES;	// error sums
+	float    fSumU, fSumUC, fSumUS;	// relay output sums
+	float    fSumC, fSumS;		// phasor sums
+	unsigned uNbrSamples;		// samples in the sums
+
+	/* per-period estimates of the current oscillation */
+	short sNbrEst;					// number of estimates
+	float fKuEst[TUNEWINDOW];		// last critical gains
+	float fPuEst[TUNEWINDOW];		// last critical periods
+} TUNESTATE;
+
+short step(float fT, float fStepAmp, float fStepDelay);
+
+void GetStepParam(float *fStepAmp, float *fStepDelay);
+
+PIDSTATE PIDInit (void);
+
+PIDCOEF PIDCompile (const PIDSET *PID, float fTs);
+
+void PIDRetune (PIDSTATE *Ctrl, PIDCOEF *Coef, const PIDSET *PID, float fTs);
+
+short PIDCtrl (PIDSTATE *Ctrl, const PIDCOEF *Coef, short sR, short sY);
 
-short PIDCtrl (unsigned char bReset, const PIDSET *PID, short sR, short sY, float fTs);
+TUNESTATE TuneInit (void);
 
-short AutoTune (unsigned char *bTuned, PIDSET *PID, float fTime, short sR, short sY, float fTs);
+short AutoTune (TUNESTATE *Tune, unsigned char *bTuned, PIDSET *PID, float fTime, short sR, short sY, float fTs);
 
 void TunedPID(PIDSET *PID);
 
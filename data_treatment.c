@@ -1,12 +1,183 @@
 #include <string.h>
 #include <stdlib.h>
 
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif // #ifndef WIN32
+
 #include "util_func.h"
 #include "data_treatment.h"
 #include "gnuplot_i.h"
 
 
 
+/**
+*  -------------------------------------------------------  *
+*  LOGOPEN() creates a binary log file for uCapacity sam-
+*  ples of uNbrChan channels. The whole file is allocated
+*  up front and mapped into memory, so logging a sample 
+*  is only a few stores. Without mmap the image is kept in
+*  memory and written with one large write on LogClose().
+*
+*  Inputs:
+*     cFileName  : name of the file to save data into
+*     lfTs       : sampling time
+*     uCapacity  : maximum number of samples
+*     uNbrChan   : number of channels
+*     cChanNames : channel names
+*     
+*  Outputs:
+*     Log: pointer to the log, NULL on failure
+*  -------------------------------------------------------  *
+*/
+LOGFILE *LogOpen (
+		   const char *cFileName,
+		   double lfTs,
+		   unsigned uCapacity,
+		   unsigned uNbrChan,
+		   const char **cChanNames
+		   )
+{
+	LOGFILE *Log;
+	
+	unsigned i;
+	
+	if (uNbrChan < 1 || uNbrChan > LOG_MAX_CHAN)
+	{
+		printf("Error: a log holds 1 to %d channels!\n", LOG_MAX_CHAN);
+		return NULL;
+	}
+	
+	Log = malloc(sizeof(LOGFILE));
+	if (Log == NULL)
+	{
+		puts("Error: memory allocaion failed!\n");
+		return NULL;
+	}
+	
+	Log->uSize = sizeof(LOGHEADER) + (size_t)uNbrChan * uCapacity * sizeof(double);
+	Log->file  = NULL;
+	
+#ifndef WIN32
+	{
+		int fd;
+		
+		fd = open(cFileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0 || ftruncate(fd, Log->uSize) != 0)
+		{
+			perror("Error opening file");
+			if (fd >= 0)
+				close(fd);
+			free(Log);
+			return NULL;
+		}
+		
+		Log->pImage = mmap(NULL, Log->uSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+		
+		if (Log->pImage == MAP_FAILED)
+		{
+			perror("Error mapping file");
+			free(Log);
+			return NULL;
+		}
+	}
+#else
+	Log->file = fopen(cFileName, "wb");
+	if (Log->file == NULL)
+	{
+		perror("Error opening file");
+		free(Log);
+		return NULL;
+	}
+	
+	Log->pImage = malloc(Log->uSize);
+	if (Log->pImage == NULL)
+	{
+		puts("Error: memory allocaion failed!\n");
+		fclose(Log->file);
+		free(Log);
+		return NULL;
+	}
+#endif // #ifndef WIN32
+	
+	/* header */
+	Log->Header = Log->pImage;
+	Log->Data   = (double *)(Log->Header + 1);
+	
+	memset(Log->Header, 0, sizeof(LOGHEADER));
+	memcpy(Log->Header->cMagic, LOG_MAGIC, sizeof(Log->Header->cMagic));
+	Log->Header->uNbrChan  = uNbrChan;
+	Log->Header->uCapacity = uCapacity;
+	Log->Header->uLength   = 0;
+	Log->Header->lfTs      = lfTs;
+	
+	for (i = 0; i < uNbrChan; i++)
+		strncpy(Log->Header->cChanName[i], cChanNames[i], LOG_NAME_LEN - 1);
+	
+	return Log;
+} // End: LogOpen()
+
+
+/**
+*  -------------------------------------------------------  *
+*  LOGWRITE() appends one sample to a binary log. Samples
+*  beyond the capacity are ignored.
+*
+*  Inputs:
+*     *Log     : pointer to an open log
+*     *lfSample: one value per channel
+*  -------------------------------------------------------  *
+*/
+void LogWrite (LOGFILE *Log, const double *lfSample)
+{
+	unsigned i, uLength, uCapacity;
+	
+	uLength   = Log->Header->uLength;
+	uCapacity = Log->Header->uCapacity;
+	
+	if (uLength >= uCapacity)
+		return;
+	
+	for (i = 0; i < Log->Header->uNbrChan; i++)
+		Log->Data[(size_t)i * uCapacity + uLength] = lfSample[i];
+	
+	Log->Header->uLength = uLength + 1;
+	
+} // End: LogWrite()
+
+
+/**
+*  -------------------------------------------------------  *
+*  LOGCLOSE() completes a binary log file and releases it.
+*
+*  Inputs:
+*     *Log: pointer to an open log
+*  -------------------------------------------------------  *
+*/
+void LogClose (LOGFILE *Log)
+{
+	if (Log == NULL)
+		return;
+	
+#ifndef WIN32
+	munmap(Log->pImage, Log->uSize);
+#else
+	if (fwrite(Log->pImage, 1, Log->uSize, Log->file) != Log->uSize)
+		perror("Error writing file");
+	
+	fclose(Log->file);
+	free(Log->pImage);
+#endif // #ifndef WIN32
+	
+	free(Log);
+	
+} // End: LogClose()
+
+
 /**
 *  -------------------------------------------------------  *
 *  SAVEDATA() saves input-output data in an specific form-
@@ -14,7 +185,7 @@
 *     DATA: {time input output}
 *
 *  Inputs:
-*     *file: pointer to an openned file
+*     *Log : pointer to a log opened with three channels
 *     time : current time instant
 *     sIn  : input value
 *     sOut : output value
@@ -24,112 +195,460 @@
 *  -------------------------------------------------------  *
 */
 void SaveData(
-	     FILE *file, 
+	     LOGFILE *Log, 
 		  double time, 
 		  short sIn, 
 		  short sOut
 		  )
 {
-	double lfIn, lfOut;
+	double lfSample[3];
 	
-	lfIn  = (double)sIn  / PREC;
-	lfOut = (double)sOut / PREC;
+	lfSample[0] = time;
+	lfSample[1] = (double)sIn  / PREC;
+	lfSample[2] = (double)sOut / PREC;
 	
-	fprintf(file, "%2.2f %2.2f %2.2f\n", time, lfIn, lfOut);
-	fflush(stdout);
+	LogWrite(Log, lfSample);
 } // End: SaveData()
 
 
 /**
 *  -------------------------------------------------------  *
-*  READIODATA() reads input-output data from a file.
+*  DATASETALLOC() allocates a trajectory buffer that the 
+*  simulation fills and the plot and analysis routines 
+*  use directly.
+*
+*  Inputs:
+*     *DataSet  : pointer to the data set
+*     uCapacity : number of samples
+*     bInternals: also keep the P, I and D contributions
+*     
+*  Outputs:
+*     0 on success, -1 if memory allocation failed
+*  -------------------------------------------------------  *
+*/
+int DataSetAlloc (DATASET *DataSet, unsigned uCapacity, unsigned char bInternals)
+{
+	unsigned uNbrChan;
+	
+	double *Data;
+	
+	memset(DataSet, 0, sizeof(DATASET));
+	
+	uNbrChan = bInternals ? DATA_NBR_CHAN : 4;
+	
+	DataSet->uSize  = sizeof(double) * uNbrChan * (size_t)uCapacity;
+	DataSet->pImage = malloc(DataSet->uSize);
+	
+	if (DataSet->pImage == NULL)
+	{
+		puts("Error: memory allocaion failed!\n");
+		DataSet->uSize = 0;
+		return -1;
+	}
+	
+	Data = DataSet->pImage;
+	
+	DataSet->Time     = Data;
+	DataSet->Input    = Data + (size_t)uCapacity;
+	DataSet->Output   = Data + (size_t)uCapacity * 2;
+	DataSet->Setpoint = Data + (size_t)uCapacity * 3;
+	
+	if (bInternals)
+	{
+		DataSet->P = Data + (size_t)uCapacity * 4;
+		DataSet->I = Data + (size_t)uCapacity * 5;
+		DataSet->D = Data + (size_t)uCapacity * 6;
+	}
+	
+	DataSet->Capacity = uCapacity;
+	
+	return 0;
+} // End: DataSetAlloc()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SAVEIODATA() writes a data set to a binary log file 
+*  with one block copy per channel.
+*
+*  Inputs:
+*     cFileName: name of the file to save data into
+*     lfTs     : sampling time
+*     *DataSet : pointer to the data set
+*
+*  Outputs:
+*     0 on success, -1 if the file cannot be written
+*  -------------------------------------------------------  *
+*/
+int SaveIOData (const char *cFileName, double lfTs, const DATASET *DataSet)
+{
+	const char *cChanNames[DATA_NBR_CHAN] = {"time", "input", "output", "setpoint", "P", "I", "D"};
+	
+	const double *Chan[DATA_NBR_CHAN];
+	
+	unsigned i, uNbrChan;
+	
+	LOGFILE *Log;
+	
+	Chan[0] = DataSet->Time;
+	Chan[1] = DataSet->Input;
+	Chan[2] = DataSet->Output;
+	Chan[3] = DataSet->Setpoint;
+	Chan[4] = DataSet->P;
+	Chan[5] = DataSet->I;
+	Chan[6] = DataSet->D;
+	
+	/* channels are stored in a fixed order up to the first missing one */
+	for (uNbrChan = 0; uNbrChan < DATA_NBR_CHAN && Chan[uNbrChan] != NULL; uNbrChan++);
+	
+	Log = LogOpen(cFileName, lfTs, DataSet->Length, uNbrChan, cChanNames);
+	if (Log == NULL)
+		return -1;
+	
+	for (i = 0; i < uNbrChan; i++)
+		memcpy(Log->Data + (size_t)i * DataSet->Length, Chan[i], sizeof(double) * DataSet->Length);
+	
+	Log->Header->uLength = DataSet->Length;
+	
+	LogClose(Log);
+	
+	return 0;
+} // End: SaveIOData()
+
+
+/**
+*  -------------------------------------------------------  *
+*  READIODATA() reads input-output data from a binary log
+*  file.
 *     DATA: {time input output}
 *
+*  The file is mapped into memory and the arrays of the 
+*  data set point directly into the channel blocks of the
+*  file, so nothing is parsed or copied. The data set has
+*  to be released with FreeIOData().
+*
 *  Inputs:
-*     *file  : pointer to an openned file
-*     uLength: length of a culomn
+*     cFileName: name of the file to read data from
 *     
 *  Outputs:
-*     DataSet: a DATASET structure
+*     DataSet: a DATASET structure (Length is 0 on failure)
 *
 *  Author: S. Ehsan Shafiei
 *          Jul. 2015
 *  -------------------------------------------------------  *
 */
-DATASET ReadIOData (FILE *file, unsigned uLength)
+DATASET ReadIOData (const char *cFileName)
 {
-	unsigned count = 0;
 	DATASET DataSet;
 	
-	/* assign dynamic size arrays. */
-	DataSet.Time   = malloc(sizeof(double) * uLength);
-	DataSet.Input  = malloc(sizeof(double) * uLength);
-	DataSet.Output = malloc(sizeof(double) * uLength);
+	const LOGHEADER *Header;
 	
-	/* check if memory are allocated successfully */
-	if (DataSet.Time == NULL || DataSet.Input == NULL || DataSet.Output == NULL)
-		puts("Error: memory allocaion failed!\n");
+	const double *Data;
 	
-	/* check for file opening. */
-	if (!file)
+	memset(&DataSet, 0, sizeof(DataSet));
+	
+#ifndef WIN32
+	{
+		int fd;
+		
+		struct stat Stat;
+		
+		fd = open(cFileName, O_RDONLY);
+		if (fd < 0 || fstat(fd, &Stat) != 0)
+		{
+			perror("Error opening file");
+			if (fd >= 0)
+				close(fd);
+			return DataSet;
+		}
+		
+		DataSet.uSize  = Stat.st_size;
+		DataSet.pImage = mmap(NULL, DataSet.uSize, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		
+		if (DataSet.pImage == MAP_FAILED)
+		{
+			perror("Error mapping file");
+			DataSet.pImage = NULL;
+			return DataSet;
+		}
+		
+		DataSet.bMapped = TRUE;
+	}
+#else
+	{
+		FILE *file;
+		
+		file = fopen(cFileName, "rb");
+		if (!file)
+		{
+			perror("Error opening file");
+			return DataSet;
+		}
+		
+		DataSet.uSize  = fsize(file);
+		DataSet.pImage = malloc(DataSet.uSize);
+		
+		if (DataSet.pImage == NULL || fread(DataSet.pImage, 1, DataSet.uSize, file) != DataSet.uSize)
+		{
+			puts("Error: reading the file failed!\n");
+			fclose(file);
+			FreeIOData(&DataSet);
+			return DataSet;
+		}
+		
+		fclose(file);
+	}
+#endif // #ifndef WIN32
+	
+	/* check the header */
+	Header = DataSet.pImage;
+	
+	if (DataSet.uSize < sizeof(LOGHEADER) || memcmp(Header->cMagic, LOG_MAGIC, sizeof(Header->cMagic))
+	    || Header->uNbrChan < 3 || Header->uLength > Header->uCapacity
+	    || DataSet.uSize < sizeof(LOGHEADER) + (size_t)Header->uNbrChan * Header->uCapacity * sizeof(double))
 	{
-		perror("Error opening file");		
+		printf("Error: %s is not an input-output log!\n", cFileName);
+		FreeIOData(&DataSet);
+		return DataSet;
 	}
 	
-	/* read data from the file. */
-	while (!feof(file) && (count < uLength))	// check for the end of file
+	/* channel blocks */
+	Data = (const double *)(Header + 1);
+	
+	DataSet.Time   = (double *)Data;
+	DataSet.Input  = (double *)Data + Header->uCapacity;
+	DataSet.Output = (double *)Data + 2 * (size_t)Header->uCapacity;
+	
+	if (Header->uNbrChan >= 4)
+		DataSet.Setpoint = (double *)Data + 3 * (size_t)Header->uCapacity;
+	
+	if (Header->uNbrChan >= DATA_NBR_CHAN)
 	{
-		fscanf(file, "%lf %lf %lf", &(DataSet.Time[count]), &(DataSet.Input[count]), &(DataSet.Output[count]));
-		fflush(stdin);		
-		count++;
+		DataSet.P = (double *)Data + 4 * (size_t)Header->uCapacity;
+		DataSet.I = (double *)Data + 5 * (size_t)Header->uCapacity;
+		DataSet.D = (double *)Data + 6 * (size_t)Header->uCapacity;
 	}
 	
-	DataSet.Length = uLength;
+	DataSet.Length   = Header->uLength;
+	DataSet.Capacity = Header->uCapacity;
 	
 	return DataSet;
 } // End: ReadIOData()
 
 
+/**
+*  -------------------------------------------------------  *
+*  FREEIODATA() releases a data set read by ReadIOData()
+*  or allocated by DataSetAlloc().
+*
+*  Inputs:
+*     *DataSet: pointer to the data set
+*  -------------------------------------------------------  *
+*/
+void FreeIOData (DATASET *DataSet)
+{
+#ifndef WIN32
+	if (DataSet->bMapped)
+		munmap(DataSet->pImage, DataSet->uSize);
+	else
+#endif // #ifndef WIN32
+		free(DataSet->pImage);
+	
+	memset(DataSet, 0, sizeof(DATASET));
+	
+} // End: FreeIOData()
+
+
+/**
+*  -------------------------------------------------------  *
+*  PLOTSAMPLES() selects the samples to plot: the union of
+*  the samples kept by PLOT_DOWNSAMPLE for every series,
+*  each series getting its share of DS_POINTS.
+*
+*  Inputs:
+*     *DataSet: data set to plot
+*     **lfY   : series to keep
+*     uNbrY   : number of series
+*
+*  Outputs:
+*     *uIdx   : increasing sample indices (DataSet->Length
+*               entries)
+*     uNbrIdx : number of samples
+*  -------------------------------------------------------  *
+*/
+static unsigned PlotSamples (const DATASET *DataSet, double **lfY, unsigned uNbrY, unsigned *uIdx)
+{
+	unsigned *uSeries, *uMerged, uMax, n, m, i;
+
+	uMax = max(DS_POINTS / uNbrY, 4);
+
+	if (PLOT_DOWNSAMPLE == DS_NONE || DataSet->Length <= DS_POINTS)
+		return Downsample(DS_NONE, NULL, NULL, DataSet->Length, DataSet->Length, uIdx);
+
+	uSeries = malloc(sizeof(unsigned) * uMax);
+	uMerged = malloc(sizeof(unsigned) * uMax * uNbrY);
+
+	if (uSeries == NULL || uMerged == NULL)
+	{
+		puts("Error: memory allocaion failed!\n");
+		free(uSeries);
+		free(uMerged);
+		return Downsample(DS_NONE, NULL, NULL, DataSet->Length, DataSet->Length, uIdx);
+	}
+
+	for (n = 0, i = 0; i < uNbrY; i++)
+	{
+		m = Downsample(PLOT_DOWNSAMPLE, DataSet->Time, lfY[i], DataSet->Length, uMax, uSeries);
+		n = DsMerge(uIdx, n, uSeries, m, uMerged);
+		memcpy(uIdx, uMerged, sizeof(unsigned) * n);
+	}
+
+	free(uSeries);
+	free(uMerged);
+
+	return n;
+} // End: PlotSamples()
+
+
 /**
 *  -------------------------------------------------------  *
 *  PLOTDATA() plots input-output data.
 *     DATA: {time input output}
+*  All signals are shown in one gnuplot session as panels
+*  with a shared time axis: output and set-point, control
+*  input and, if logged, the P, I and D parts. The data is
+*  uploaded once, downsampled with PLOT_DOWNSAMPLE.
 *
 *  Inputs:
-*     cFileName: name of the file to read data from
-*     uLength  : length of a culomn
+*     *DataSet: pointer to the data set to plot
 *     
 *  Author: S. Ehsan Shafiei
 *          Jul. 2015
 *  -------------------------------------------------------  *
 */
-void	PlotData(const char *cFileName, unsigned uLength)
+void	PlotData(const DATASET *DataSet)
 {
-	DATASET IOData;
-	
-	FILE *DataFile;
-	
-	DataFile = fopen(cFileName, "r");
-	IOData = ReadIOData(DataFile, uLength);
-	fclose(DataFile);
-	
-//	gnuplot_ctrl *h;
-//	h = gnuplot_init();
-	
-	fflush(stdin);
-	gnuplot_plot_once("Input Data", "lines", "tim [sec]", "Input",   IOData.Time, IOData.Input, IOData.Length);
-	
-	fflush(stdin);	
-	gnuplot_plot_once("Output Data", "lines", "tim [sec]", "Output", IOData.Time, IOData.Output, IOData.Length);
+	gnuplot_ctrl *h;
+
+	double *lfCol[DATA_NBR_CHAN], *lfY[5];
+
+	const double *lfCols[DATA_NBR_CHAN];
+
+	char const *cFile;
+
+	char cUsing[32];
+
+	unsigned *uIdx, uNbrY, uNbrCol, n, i, j;
+
+	unsigned char bSetpoint, bPID;
+
+	if (DataSet->Length == 0)
+		return;
+
+	bSetpoint = (DataSet->Setpoint != NULL);
+	bPID      = (DataSet->P != NULL && DataSet->I != NULL && DataSet->D != NULL);
+
+	/* columns: time input output [set-point] [P I D] */
+	uNbrY = 0;
+	lfY[uNbrY++] = DataSet->Input;
+	lfY[uNbrY++] = DataSet->Output;
+	if (bSetpoint)
+		lfY[uNbrY++] = DataSet->Setpoint;
+	if (bPID)
+	{
+		lfY[uNbrY++] = DataSet->P;
+		lfY[uNbrY++] = DataSet->I;
+		lfY[uNbrY++] = DataSet->D;
+	}
+	uNbrCol = uNbrY + 1;
+
+	uIdx = malloc(sizeof(unsigned) * DataSet->Length);
+	for (i = 0; i < uNbrCol; i++)
+		lfCol[i] = (uIdx == NULL) ? NULL : malloc(sizeof(double) * min(DataSet->Length, DS_POINTS * uNbrY));
+
+	for (i = 0; i < uNbrCol; i++)
+		if (lfCol[i] == NULL)
+			break;
+
+	if (i < uNbrCol)
+	{
+		puts("Error: memory allocaion failed!\n");
+		n = 0;
+	}
+	else
+	{
+		n = PlotSamples(DataSet, lfY, uNbrY, uIdx);
+
+		for (j = 0; j < n; j++)
+		{
+			lfCol[0][j] = DataSet->Time[uIdx[j]];
+			for (i = 1; i < uNbrCol; i++)
+				lfCol[i][j] = lfY[i - 1][uIdx[j]];
+		}
+	}
+
+	h = (n > 0) ? gnuplot_init() : NULL;
+
+	for (i = 0; i < uNbrCol; i++)
+		lfCols[i] = lfCol[i];
+
+	cFile = (h != NULL) ? gnuplot_write_columns(h, lfCols, uNbrCol, n) : NULL;
+
+	if (cFile != NULL)
+	{
+		if (h->binary)
+			sprintf(cUsing, "binary format=\"%%%udouble\" using", uNbrCol);
+		else
+			strcpy(cUsing, "using");
+
+		gnuplot_cmd(h, "set multiplot layout %u,1", bPID ? 3 : 2);
+		gnuplot_cmd(h, "set grid");
+		gnuplot_cmd(h, "set lmargin 10");
+		gnuplot_cmd(h, "set xrange [%g:%g]", lfCol[0][0], lfCol[0][n - 1]);
+		gnuplot_cmd(h, "set format x \"\"");
+
+		gnuplot_cmd(h, "set ylabel \"Output\"");
+		if (bSetpoint)
+			gnuplot_cmd(h, "plot \"%s\" %s 1:3 title \"Output\" with lines, \"\" %s 1:4 title \"Set-point\" with lines",
+			            cFile, cUsing, cUsing);
+		else
+			gnuplot_cmd(h, "plot \"%s\" %s 1:3 title \"Output\" with lines", cFile, cUsing);
+
+		if (!bPID)
+		{
+			gnuplot_cmd(h, "set format x");
+			gnuplot_cmd(h, "set xlabel \"time [sec]\"");
+		}
+		gnuplot_cmd(h, "set ylabel \"Input\"");
+		gnuplot_cmd(h, "plot \"%s\" %s 1:2 title \"Input\" with lines", cFile, cUsing);
+
+		if (bPID)
+		{
+			j = uNbrCol - 2;	// column of P
+			gnuplot_cmd(h, "set format x");
+			gnuplot_cmd(h, "set xlabel \"time [sec]\"");
+			gnuplot_cmd(h, "set ylabel \"PID parts\"");
+			gnuplot_cmd(h, "plot \"%s\" %s 1:%u title \"P\" with lines, \"\" %s 1:%u title \"I\" with lines, "
+			               "\"\" %s 1:%u title \"D\" with lines", cFile, cUsing, j, cUsing, j + 1, cUsing, j + 2);
+		}
+
+		gnuplot_cmd(h, "unset multiplot");
+
+		fflush(stdin);
+		printf("press ENTER to continue\n");
+		while (getchar() != '\n') {}
+	}
+
+	if (h != NULL)
+		gnuplot_close(h);
+
+	for (i = 0; i < uNbrCol; i++)
+		free(lfCol[i]);
+	free(uIdx);
 
-//	gnuplot_close(h);
 	fflush(stdout);
 	
-	/* release the allocated memory. */
-	free(IOData.Time)  ;
-	free(IOData.Input) ;
-	free(IOData.Output);
-	
 } // End: PlotData()
 	
 	
@@ -4,19 +4,67 @@
 #include <stdio.h>
 
 #include "simulation.h"
+#include "downsample.h"
+
+#define LOG_MAGIC       "ATLOG01"	// file signature (8 bytes with the terminator)
+#define LOG_MAX_CHAN    8			// maximum number of channels
+#define LOG_NAME_LEN    16			// channel name length
+
+#define DATA_NBR_CHAN   7	// time, input, output, set-point and P, I, D parts
+
+#define PLOT_DOWNSAMPLE DS_LTTB	// downsampling of plotted series (downsample.h)
 
 typedef struct tagDataSet {
-	double 	*Time  ;
-	double 	*Input ;
-	double 	*Output;
-	unsigned Length ;
+	double 	*Time    ;
+	double 	*Input   ;
+	double 	*Output  ;
+	double 	*Setpoint;	// NULL if not available
+	double 	*P, *I, *D;	// PID contributions, NULL if not available
+	unsigned Length   ;
+	unsigned Capacity ;	// number of samples the arrays can hold
+	void    *pImage   ;	// memory the arrays point into
+	size_t   uSize    ;	// size of the memory
+	unsigned char bMapped;	// pImage is a mapped file
 } DATASET;
 
-void SaveData(FILE *file, double time, short sIn, short sOut);
+/* binary log layout: the header is followed by one block of
+   uCapacity doubles per channel, so every channel can be used
+   in place as an array */
+typedef struct tagLogHeader {
+	char     cMagic[8];								// LOG_MAGIC
+	unsigned uNbrChan;								// number of channels
+	unsigned uCapacity;								// samples reserved per channel
+	unsigned uLength;								// samples written per channel
+	unsigned uReserved;
+	double   lfTs;									// sampling time
+	char     cChanName[LOG_MAX_CHAN][LOG_NAME_LEN];	// channel names
+} LOGHEADER;
+
+typedef struct tagLogFile {
+	LOGHEADER *Header;	// header inside the file image
+	double    *Data;		// first channel block
+	void      *pImage;	// file image
+	size_t     uSize;		// size of the file image
+	FILE      *file;		// file written on close (no mmap)
+} LOGFILE;
+
+LOGFILE *LogOpen (const char *cFileName, double lfTs, unsigned uCapacity, unsigned uNbrChan, const char **cChanNames);
+
+void LogWrite (LOGFILE *Log, const double *lfSample);
+
+void LogClose (LOGFILE *Log);
+
+void SaveData(LOGFILE *Log, double time, short sIn, short sOut);
+
+int DataSetAlloc (DATASET *DataSet, unsigned uCapacity, unsigned char bInternals);
+
+int SaveIOData (const char *cFileName, double lfTs, const DATASET *DataSet);
+
+DATASET ReadIOData (const char *cFileName);
 
-DATASET ReadIOData (FILE *file, unsigned uLength);
+void FreeIOData (DATASET *DataSet);
 
-void	PlotData(const char *cFileName, unsigned uLength);
+void	PlotData(const DATASET *DataSet);
 
 unsigned long fsize(FILE *file);
 
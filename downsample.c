@@ -0,0 +1,249 @@
+#include <math.h>
+
+#include "downsample.h"
+
+
+/**
+*  -------------------------------------------------------  *
+*  DSALL() selects every sample.
+*  -------------------------------------------------------  *
+*/
+static unsigned DsAll (unsigned uNbr, unsigned *uIdx)
+{
+	unsigned i;
+
+	for (i = 0; i < uNbr; i++)
+		uIdx[i] = i;
+
+	return uNbr;
+} // End: DsAll()
+
+
+/**
+*  -------------------------------------------------------  *
+*  DSMINMAX() selects the smallest and the largest sample
+*  of uMax/2 equal buckets, in time order, plus the first
+*  and the last sample. Every extreme of the signal, like
+*  the relay peaks, stays in the plot.
+*
+*  Inputs:
+*     *lfY: samples
+*     uNbr: number of samples
+*     uMax: maximum number of samples to keep (>= 4)
+*
+*  Outputs:
+*     *uIdx: indices of the kept samples (uMax entries)
+*     uNbrIdx: number of kept samples
+*  -------------------------------------------------------  *
+*/
+unsigned DsMinMax (const double *lfY, unsigned uNbr, unsigned uMax, unsigned *uIdx)
+{
+	unsigned uNbrBuckets, uBucket, uStart, uEnd, uMin, uMaxIdx, i, n = 0;
+
+	if (uNbr <= uMax || uMax < 4)
+		return DsAll(uNbr, uIdx);
+
+	uNbrBuckets = (uMax - 2) / 2;
+
+	uIdx[n++] = 0;
+
+	for (uBucket = 0; uBucket < uNbrBuckets; uBucket++)
+	{
+		/* bucket over samples 1 ... uNbr-2 */
+		uStart = 1 + (unsigned)((double)uBucket * (uNbr - 2) / uNbrBuckets);
+		uEnd   = 1 + (unsigned)((double)(uBucket + 1) * (uNbr - 2) / uNbrBuckets);
+
+		if (uStart >= uEnd)
+			continue;
+
+		uMin = uMaxIdx = uStart;
+
+		for (i = uStart + 1; i < uEnd; i++)
+		{
+			if (lfY[i] < lfY[uMin])
+				uMin = i;
+			if (lfY[i] > lfY[uMaxIdx])
+				uMaxIdx = i;
+		}
+
+		if (uMin == uMaxIdx)
+			uIdx[n++] = uMin;
+		else if (uMin < uMaxIdx)
+		{
+			uIdx[n++] = uMin;
+			uIdx[n++] = uMaxIdx;
+		}
+		else
+		{
+			uIdx[n++] = uMaxIdx;
+			uIdx[n++] = uMin;
+		}
+	}
+
+	uIdx[n++] = uNbr - 1;
+
+	return n;
+} // End: DsMinMax()
+
+
+/**
+*  -------------------------------------------------------  *
+*  DSLTTB() selects samples with the Largest-Triangle-Th-
+*  ree-Buckets method: one sample per bucket, the one that
+*  spans the largest triangle with the sample kept in the
+*  previous bucket and the mean of the next bucket. The
+*  shape and the visible peaks of the signal are kept.
+*
+*  Inputs:
+*     *lfX: sample times
+*     *lfY: samples
+*     uNbr: number of samples
+*     uMax: maximum number of samples to keep (>= 3)
+*
+*  Outputs:
+*     *uIdx: indices of the kept samples (uMax entries)
+*     uNbrIdx: number of kept samples
+*  -------------------------------------------------------  *
+*/
+unsigned DsLTTB (const double *lfX, const double *lfY, unsigned uNbr, unsigned uMax, unsigned *uIdx)
+{
+	double lfEvery, lfXMean, lfYMean, lfArea, lfAreaMax;
+
+	unsigned uBucket, uStart, uEnd, uNextStart, uNextEnd, uA, i, n = 0;
+
+	if (uNbr <= uMax || uMax < 3)
+		return DsAll(uNbr, uIdx);
+
+	lfEvery = (double)(uNbr - 2) / (uMax - 2);
+
+	uA = 0;
+	uIdx[n++] = 0;
+
+	for (uBucket = 0; uBucket < uMax - 2; uBucket++)
+	{
+		uStart = 1 + (unsigned)(uBucket * lfEvery);
+		uEnd   = 1 + (unsigned)((uBucket + 1) * lfEvery);
+
+		/* mean of the next bucket (the last sample for the last bucket) */
+		uNextStart = uEnd;
+		uNextEnd   = (uBucket + 2 < uMax - 1) ? 1 + (unsigned)((uBucket + 2) * lfEvery) : uNbr;
+		uNextEnd   = (uNextEnd > uNbr) ? uNbr : uNextEnd;
+
+		lfXMean = lfYMean = 0;
+
+		for (i = uNextStart; i < uNextEnd; i++)
+		{
+			lfXMean += lfX[i];
+			lfYMean += lfY[i];
+		}
+
+		if (uNextEnd > uNextStart)
+		{
+			lfXMean /= uNextEnd - uNextStart;
+			lfYMean /= uNextEnd - uNextStart;
+		}
+		else
+		{
+			lfXMean = lfX[uNbr - 1];
+			lfYMean = lfY[uNbr - 1];
+		}
+
+		/* sample of this bucket with the largest triangle */
+		lfAreaMax = -1;
+
+		for (i = uStart; i < uEnd; i++)
+		{
+			lfArea = fabs((lfX[uA] - lfXMean) * (lfY[i] - lfY[uA]) - (lfX[uA] - lfX[i]) * (lfYMean - lfY[uA]));
+
+			if (lfArea > lfAreaMax)
+			{
+				lfAreaMax = lfArea;
+				uIdx[n]   = i;
+			}
+		}
+
+		if (lfAreaMax >= 0)
+			uA = uIdx[n++];
+	}
+
+	uIdx[n++] = uNbr - 1;
+
+	return n;
+} // End: DsLTTB()
+
+
+/**
+*  -------------------------------------------------------  *
+*  DOWNSAMPLE() selects at most uMax samples of a series
+*  with the given method.
+*
+*  Inputs:
+*     sMethod: DS_NONE, DS_MINMAX or DS_LTTB
+*     *lfX   : sample times
+*     *lfY   : samples
+*     uNbr   : number of samples
+*     uMax   : maximum number of samples to keep
+*
+*  Outputs:
+*     *uIdx  : indices of the kept samples, increasing (uN-
+*              br entries for DS_NONE, else uMax)
+*     uNbrIdx: number of kept samples
+*  -------------------------------------------------------  *
+*/
+unsigned Downsample (
+		   short sMethod,
+		   const double *lfX,
+		   const double *lfY,
+		   unsigned uNbr,
+		   unsigned uMax,
+		   unsigned *uIdx
+		   )
+{
+	switch (sMethod)
+	{
+		case DS_MINMAX:
+			return DsMinMax(lfY, uNbr, uMax, uIdx);
+
+		case DS_LTTB:
+			return DsLTTB(lfX, lfY, uNbr, uMax, uIdx);
+
+		default:
+			return DsAll(uNbr, uIdx);
+	}
+} // End: Downsample()
+
+
+/**
+*  -------------------------------------------------------  *
+*  DSMERGE() joins two increasing index lists, so samples
+*  kept for either of two series of the same time base
+*  can be sent together.
+*
+*  Inputs:
+*     *uA, uNbrA: first index list
+*     *uB, uNbrB: second index list
+*
+*  Outputs:
+*     *uIdx  : increasing union (uNbrA + uNbrB entries)
+*     uNbrIdx: number of indices in the union
+*  -------------------------------------------------------  *
+*/
+unsigned DsMerge (const unsigned *uA, unsigned uNbrA, const unsigned *uB, unsigned uNbrB, unsigned *uIdx)
+{
+	unsigned i = 0, j = 0, n = 0;
+
+	while (i < uNbrA || j < uNbrB)
+	{
+		if (j >= uNbrB || (i < uNbrA && uA[i] < uB[j]))
+			uIdx[n++] = uA[i++];
+		else if (i >= uNbrA || uB[j] < uA[i])
+			uIdx[n++] = uB[j++];
+		else
+		{
+			uIdx[n++] = uA[i++];
+			j++;
+		}
+	}
+
+	return n;
+} // End: DsMerge()
@@ -0,0 +1,21 @@
+#ifndef __DOWNSAMPLE_H__
+#define __DOWNSAMPLE_H__
+
+#define DS_POINTS   2000   // points kept per series, about a screen width
+
+enum DsMethod
+{
+	DS_NONE,		// 0: every sample
+	DS_MINMAX,		// 1: min/max envelope per bucket
+	DS_LTTB		// 2: largest triangle three buckets
+};
+
+unsigned DsMinMax (const double *lfY, unsigned uNbr, unsigned uMax, unsigned *uIdx);
+
+unsigned DsLTTB (const double *lfX, const double *lfY, unsigned uNbr, unsigned uMax, unsigned *uIdx);
+
+unsigned Downsample (short sMethod, const double *lfX, const double *lfY, unsigned uNbr, unsigned uMax, unsigned *uIdx);
+
+unsigned DsMerge (const unsigned *uA, unsigned uNbrA, const unsigned *uB, unsigned uNbrB, unsigned *uIdx);
+
+#endif // __DOWNSAMPLE_H__
@@ -0,0 +1,679 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "fixed_point.h"
+#include "util_func.h"
+
+#define FIX_BENCH_SAMPLES   2000000   // samples timed per path in FixCheck()
+
+// double precision loop used as the reference of FixCheck()
+typedef struct tagRefLoop {
+	double lfU[LTI_MAX_ORDER + 1], lfY[LTI_MAX_ORDER + 1];	// plant memory (direct form I)
+	double lfI, lfDOld, lfYOld;								// PID memory
+	double lfUin;												// plant input
+} REFLOOP;
+
+// error statistics of one path against the reference
+typedef struct tagFixError {
+	double lfYMax, lfYSq;	// output error: maximum and sum of squares
+	double lfUMax, lfUSq;	// command error: maximum and sum of squares
+} FIXERROR;
+
+
+/**
+*  -------------------------------------------------------  *
+*  WORDMIN(), WORDMAX() return the range of a signal word.
+*  -------------------------------------------------------  *
+*/
+static int64_t WordMin (const FIXFORMAT *Fmt)
+{
+	return -((int64_t)1 << (Fmt->uWordBits - 1));
+} // End: WordMin()
+
+static int64_t WordMax (const FIXFORMAT *Fmt)
+{
+	return ((int64_t)1 << (Fmt->uWordBits - 1)) - 1;
+} // End: WordMax()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SATWORD() saturates a value to the signal word.
+*  -------------------------------------------------------  *
+*/
+static int32_t SatWord (int64_t llX, const FIXFORMAT *Fmt)
+{
+	return (int32_t)sat(llX, WordMin(Fmt), WordMax(Fmt));
+} // End: SatWord()
+
+
+/**
+*  -------------------------------------------------------  *
+*  ACCADD() adds two accumulators with saturation.
+*  -------------------------------------------------------  *
+*/
+static int64_t AccAdd (int64_t llA, int64_t llB)
+{
+	int64_t llSum;
+
+	if (__builtin_add_overflow(llA, llB, &llSum))
+		return (llA < 0) ? INT64_MIN : INT64_MAX;
+
+	return llSum;
+} // End: AccAdd()
+
+
+/**
+*  -------------------------------------------------------  *
+*  ROUNDSHIFT() drops uShift fraction bits with rounding
+*  to nearest. Shifts of negative values are arithmetic.
+*  -------------------------------------------------------  *
+*/
+static int64_t RoundShift (int64_t llX, unsigned uShift)
+{
+	if (uShift == 0)
+		return llX;
+
+	return AccAdd(llX, (int64_t)1 << (uShift - 1)) >> uShift;
+} // End: RoundShift()
+
+
+/**
+*  -------------------------------------------------------  *
+*  FIXFORMAT() returns the default Q format for a signal
+*  word length: Q4.11 signals for 16 bits (range +-16) and
+*  Q7.24 signals for 32 bits (range +-128). Coefficients
+*  have 11 integer bits for the derivative gain K N.
+*
+*  Inputs:
+*     uWordBits: signal word length, 16 or 32
+*
+*  Outputs:
+*     Fmt: Q format
+*  -------------------------------------------------------  *
+*/
+FIXFORMAT FixFormat (unsigned uWordBits)
+{
+	FIXFORMAT Fmt;
+
+	if (uWordBits <= 16)
+	{
+		Fmt.uWordBits = 16;
+		Fmt.uSigFrac  = 11;
+	}
+	else
+	{
+		Fmt.uWordBits = 32;
+		Fmt.uSigFrac  = 24;
+	}
+
+	Fmt.uCoefFrac = 20;
+
+	return Fmt;
+} // End: FixFormat()
+
+
+/**
+*  -------------------------------------------------------  *
+*  FIXPARSEFORMAT() reads a Q format given as "bits" or
+*  "bits:signal_fraction:coefficient_fraction".
+*
+*  Inputs:
+*     cFormat: format text
+*
+*  Outputs:
+*     *Fmt: Q format
+*     0 on success, -1 on failure
+*  -------------------------------------------------------  *
+*/
+int FixParseFormat (const char *cFormat, FIXFORMAT *Fmt)
+{
+	unsigned uBits, uSigFrac, uCoefFrac;
+
+	int iNbr;
+
+	iNbr = sscanf(cFormat, "%u:%u:%u", &uBits, &uSigFrac, &uCoefFrac);
+
+	if (iNbr < 1 || (uBits != 16 && uBits != 32))
+		return -1;
+
+	*Fmt = FixFormat(uBits);
+
+	if (iNbr == 3)
+	{
+		if (uSigFrac >= uBits || uCoefFrac > 30)
+			return -1;
+
+		Fmt->uSigFrac  = uSigFrac;
+		Fmt->uCoefFrac = uCoefFrac;
+	}
+	else if (iNbr != 1)
+		return -1;
+
+	return 0;
+} // End: FixParseFormat()
+
+
+/**
+*  -------------------------------------------------------  *
+*  FIXFROMFLOAT() converts a real value to a saturated
+*  fixed-point word.
+*
+*  Inputs:
+*     lfX      : real value
+*     uFrac    : number of fraction bits
+*     uWordBits: word length
+*
+*  Outputs:
+*     iX: fixed-point value
+*  -------------------------------------------------------  *
+*/
+int32_t FixFromFloat (double lfX, unsigned uFrac, unsigned uWordBits)
+{
+	double lfMax = ldexp(1, uWordBits - 1) - 1;
+
+	lfX = floor(ldexp(lfX, uFrac) + 0.5);
+
+	return (int32_t)sat(lfX, -lfMax - 1, lfMax);
+} // End: FixFromFloat()
+
+
+/**
+*  -------------------------------------------------------  *
+*  FIXCONVERT() is FixFromFloat() for the constants of a
+*  loop: a value out of the range of the word is an error
+*  instead of being saturated.
+*
+*  Inputs:
+*     lfX      : real value
+*     uFrac    : number of fraction bits
+*     uWordBits: word length
+*     cName    : name of the constant for the error text
+*
+*  Outputs:
+*     *iX: fixed-point value
+*     0 on success, -1 if lfX does not fit
+*  -------------------------------------------------------  *
+*/
+static int FixConvert (double lfX, unsigned uFrac, unsigned uWordBits, const char *cName, int32_t *iX)
+{
+	double lfMax = ldexp(1, uWordBits - 1) - 1, lfQ;
+
+	lfQ = floor(ldexp(lfX, uFrac) + 0.5);
+
+	if (lfQ < -lfMax - 1 || lfQ > lfMax)
+	{
+		printf("Error: %s = %g is out of the range of Q%d.%u!\n", cName, lfX, (int)uWordBits - 1 - (int)uFrac, uFrac);
+		return -1;
+	}
+
+	*iX = FixFromFloat(lfX, uFrac, uWordBits);
+
+	return 0;
+} // End: FixConvert()
+
+
+/**
+*  -------------------------------------------------------  *
+*  FIXTOFLOAT() converts a fixed-point value to real.
+*
+*  Inputs:
+*     llX  : fixed-point value
+*     uFrac: number of fraction bits
+*  -------------------------------------------------------  *
+*/
+double FixToFloat (int64_t llX, unsigned uFrac)
+{
+	return ldexp((double)llX, -(int)uFrac);
+} // End: FixToFloat()
+
+
+/**
+*  -------------------------------------------------------  *
+*  FIXPIDCOMPILE() quantizes the compiled PID constants.
+*  Every constant that does not fit its format is report-
+*  ed.
+*
+*  Inputs:
+*     *Coef: PID constants from PIDCompile()
+*     *Fmt : Q format
+*
+*  Outputs:
+*     *PID: PID constants in coefficient format
+*     0 on success, -1 if a constant is out of range
+*  -------------------------------------------------------  *
+*/
+int FixPIDCompile (const PIDCOEF *Coef, const FIXFORMAT *Fmt, FIXPID *PID)
+{
+	int iStatus = 0;
+
+	iStatus |= FixConvert(Coef->fK  , Fmt->uCoefFrac, 32, "PID K"  , &PID->iK);
+	iStatus |= FixConvert(Coef->fKd1, Fmt->uCoefFrac, 32, "PID Kd1", &PID->iKd1);
+	iStatus |= FixConvert(Coef->fKd2, Fmt->uCoefFrac, 32, "PID Kd2", &PID->iKd2);
+	iStatus |= FixConvert(Coef->fKi , Fmt->uCoefFrac, 32, "PID Ki" , &PID->iKi);
+	iStatus |= FixConvert(Coef->fKt , Fmt->uCoefFrac, 32, "PID Kt" , &PID->iKt);
+	iStatus |= FixConvert(UMIN, Fmt->uSigFrac, Fmt->uWordBits, "UMIN", &PID->iUMin);
+	iStatus |= FixConvert(UMAX, Fmt->uSigFrac, Fmt->uWordBits, "UMAX", &PID->iUMax);
+
+	return iStatus;
+} // End: FixPIDCompile()
+
+
+/**
+*  -------------------------------------------------------  *
+*  FIXPIDINIT() initializes the memory of a fixed-point
+*  PID controller.
+*  -------------------------------------------------------  *
+*/
+FIXPIDSTATE FixPIDInit (void)
+{
+	FIXPIDSTATE Ctrl;
+
+	Ctrl.llI   = 0;
+	Ctrl.iDOld = 0;
+	Ctrl.iYOld = 0;
+
+	return Ctrl;
+} // End: FixPIDInit()
+
+
+/**
+*  -------------------------------------------------------  *
+*  FIXPIDCTRL() is PIDCtrl() in integer arithmetic. The
+*  integral part is kept in accumulator format, so small
+*  integrator increments are not lost to rounding.
+*
+*  Inputs:
+*     *Ctrl: pointer to the controller state
+*     *PID : PID constants in coefficient format
+*     *Fmt : Q format
+*     iR   : setpoint in signal format
+*     iY   : plant output in signal format
+*
+*  Outputs:
+*     iU: control command in signal format
+*  -------------------------------------------------------  *
+*/
+int32_t FixPIDCtrl (
+		   FIXPIDSTATE *Ctrl,
+		   const FIXPID *PID,
+		   const FIXFORMAT *Fmt,
+		   int32_t iR,
+		   int32_t iY
+		   )
+{
+	int32_t iError, iDY, iU;
+
+	int64_t llP, llD, llV;
+
+	unsigned uShift = Fmt->uCoefFrac;
+
+	/* error signal */
+	iError = SatWord((int64_t)iR - iY, Fmt);
+
+	/* proportional part */
+	llP = (int64_t)PID->iK * iError;
+
+	/* derivative part */
+	iDY = SatWord((int64_t)iY - Ctrl->iYOld, Fmt);
+	llD = AccAdd((int64_t)PID->iKd1 * Ctrl->iDOld, -(int64_t)PID->iKd2 * iDY);
+
+	/* paralle PID */
+	llV = AccAdd(AccAdd(llP, Ctrl->llI), llD);
+
+	/* saturation filter */
+	iU = SatWord(RoundShift(llV, uShift), Fmt);
+	iU = sat(iU, PID->iUMin, PID->iUMax);
+
+	/* integrator update including anti-windup */
+	Ctrl->llI = AccAdd(Ctrl->llI, (int64_t)PID->iKi * iError);
+	Ctrl->llI = AccAdd(Ctrl->llI, (int64_t)PID->iKt * SatWord(iU - RoundShift(llV, uShift), Fmt));
+	Ctrl->llI = sat(Ctrl->llI, WordMin(Fmt) << uShift, WordMax(Fmt) << uShift);
+
+	/* updates */
+	Ctrl->iDOld = SatWord(RoundShift(llD, uShift), Fmt);
+	Ctrl->iYOld = iY;
+
+	return iU;
+} // End: FixPIDCtrl()
+
+
+/**
+*  -------------------------------------------------------  *
+*  FIXPLANTCOMPILE() quantizes the difference equation of
+*  a discrete plant. Every coefficient that does not fit
+*  the coefficient format is reported.
+*
+*  Inputs:
+*     *Disc: difference equation from LtiDiscretize()
+*     *Fmt : Q format
+*
+*  Outputs:
+*     *Plant: difference equation in coefficient format
+*     0 on success, -1 if a coefficient is out of range
+*  -------------------------------------------------------  *
+*/
+int FixPlantCompile (const LTIDISC *Disc, const FIXFORMAT *Fmt, FIXPLANT *Plant)
+{
+	char cName[16];
+
+	int iStatus = 0;
+
+	unsigned i;
+
+	memset(Plant, 0, sizeof(FIXPLANT));
+
+	Plant->uOrder = Disc->uOrder;
+
+	for (i = 0; i <= Disc->uOrder; i++)
+	{
+		sprintf(cName, "plant b%u", i);
+		iStatus |= FixConvert(Disc->lfB[i], Fmt->uCoefFrac, 32, cName, &Plant->iB[i]);
+
+		sprintf(cName, "plant a%u", i);
+		iStatus |= FixConvert(Disc->lfA[i], Fmt->uCoefFrac, 32, cName, &Plant->iA[i]);
+	}
+
+	iStatus |= FixConvert(UMIN, Fmt->uSigFrac, Fmt->uWordBits, "UMIN", &Plant->iUMin);
+	iStatus |= FixConvert(UMAX, Fmt->uSigFrac, Fmt->uWordBits, "UMAX", &Plant->iUMax);
+
+	return iStatus;
+} // End: FixPlantCompile()
+
+
+/**
+*  -------------------------------------------------------  *
+*  FIXPLANTINIT() initializes the memory of a fixed-point
+*  plant.
+*  -------------------------------------------------------  *
+*/
+FIXPLANTSTATE FixPlantInit (void)
+{
+	FIXPLANTSTATE Plant;
+
+	unsigned i;
+
+	for (i = 0; i <= LTI_MAX_ORDER; i++)
+	{
+		Plant.iU[i] = 0;
+		Plant.iY[i] = 0;
+	}
+
+	return Plant;
+} // End: FixPlantInit()
+
+
+/**
+*  -------------------------------------------------------  *
+*  FIXPLANTSTEP() is LtiStep() in integer arithmetic. The
+*  direct form I sums all products in one accumulator and
+*  rounds only the output.
+*
+*  Inputs:
+*     *Plant: pointer to the plant state
+*     *Coef : difference equation in coefficient format
+*     *Fmt  : Q format
+*     iUin  : plant input in signal format
+*
+*  Outputs:
+*     iY: plant output in signal format
+*  -------------------------------------------------------  *
+*/
+int32_t FixPlantStep (
+		   FIXPLANTSTATE *Plant,
+		   const FIXPLANT *Coef,
+		   const FIXFORMAT *Fmt,
+		   int32_t iUin
+		   )
+{
+	int64_t llAcc;
+
+	int32_t iY;
+
+	unsigned i, n = Coef->uOrder;
+
+	/* update inputs */
+	for (i = n; i > 0; i--)
+		Plant->iU[i] = Plant->iU[i - 1];
+
+	Plant->iU[0] = sat(iUin, Coef->iUMin, Coef->iUMax);
+
+	/* calculate the output */
+	llAcc = (int64_t)Coef->iB[0] * Plant->iU[0];
+
+	for (i = 1; i <= n; i++)
+	{
+		llAcc = AccAdd(llAcc,  (int64_t)Coef->iB[i] * Plant->iU[i]);
+		llAcc = AccAdd(llAcc, -(int64_t)Coef->iA[i] * Plant->iY[i]);
+	}
+
+	iY = SatWord(RoundShift(llAcc, Fmt->uCoefFrac), Fmt);
+
+	/* update outputs */
+	for (i = n; i > 1; i--)
+		Plant->iY[i] = Plant->iY[i - 1];
+
+	if (n > 0)
+		Plant->iY[1] = iY;
+
+	return iY;
+} // End: FixPlantStep()
+
+
+/**
+*  -------------------------------------------------------  *
+*  REFSTEP() advances the double precision reference loop
+*  by one sample, in the order of LoopStep().
+*  -------------------------------------------------------  *
+*/
+static double RefStep (
+		   REFLOOP *Ref,
+		   const LTIDISC *Disc,
+		   const PIDCOEF *Coef,
+		   double lfR,
+		   unsigned char bCtrl
+		   )
+{
+	double lfY, lfE, lfD, lfV, lfU;
+
+	unsigned i, n = Disc->uOrder;
+
+	/* plant */
+	for (i = n; i > 0; i--)
+		Ref->lfU[i] = Ref->lfU[i - 1];
+
+	Ref->lfU[0] = sat(Ref->lfUin, UMIN, UMAX);
+
+	lfY = Disc->lfB[0] * Ref->lfU[0];
+
+	for (i = 1; i <= n; i++)
+		lfY += Disc->lfB[i] * Ref->lfU[i] - Disc->lfA[i] * Ref->lfY[i];
+
+	for (i = n; i > 1; i--)
+		Ref->lfY[i] = Ref->lfY[i - 1];
+
+	if (n > 0)
+		Ref->lfY[1] = lfY;
+
+	/* controller */
+	if (bCtrl)
+	{
+		lfE = lfR - lfY;
+		lfD = Coef->fKd1 * Ref->lfDOld - Coef->fKd2 * (lfY - Ref->lfYOld);
+		lfV = Coef->fK * lfE + Ref->lfI + lfD;
+		lfU = sat(lfV, UMIN, UMAX);
+
+		Ref->lfI   += Coef->fKi * lfE + Coef->fKt * (lfU - lfV);
+		Ref->lfDOld = lfD;
+		Ref->lfYOld = lfY;
+		Ref->lfUin  = lfU;
+	}
+
+	return lfY;
+} // End: RefStep()
+
+
+/**
+*  -------------------------------------------------------  *
+*  ADDERROR() accumulates the deviation of one sample.
+*  -------------------------------------------------------  *
+*/
+static void AddError (FIXERROR *Err, double lfY, double lfYRef, double lfU, double lfURef)
+{
+	Err->lfYMax = max(Err->lfYMax, fabs(lfY - lfYRef));
+	Err->lfUMax = max(Err->lfUMax, fabs(lfU - lfURef));
+	Err->lfYSq += (lfY - lfYRef) * (lfY - lfYRef);
+	Err->lfUSq += (lfU - lfURef) * (lfU - lfURef);
+} // End: AddError()
+
+
+/**
+*  -------------------------------------------------------  *
+*  FIXCHECK() runs the set-point response of the built-in
+*  plant with three implementations of the same loop and
+*  reports their deviation and speed:
+*
+*     double: reference in double precision
+*     float : the simulation path (LoopStep(), PREC scaled
+*             short signals)
+*     fixed : integer path (FixPlantStep(), FixPIDCtrl())
+*
+*  Inputs:
+*     *Fmt     : Q format of the integer path
+*     *PID     : PID gains
+*     fSetpoint: set-point
+*     *SimSet  : structure of the simulation settings
+*
+*  Outputs:
+*     0 on success, -1 on failure or if a constant of the
+*     loop is out of the range of its format
+*  -------------------------------------------------------  *
+*/
+int FixCheck (const FIXFORMAT *Fmt, const PIDSET *PID, float fSetpoint, const SIMSET *SimSet)
+{
+	LTIMODEL Model;
+
+	LTIDISC Disc;
+
+	PIDCOEF Coef;
+
+	CASESET Case;
+
+	LOOP Loop;
+
+	REFLOOP Ref = {{0}};
+
+	FIXPLANT FixPlant;
+
+	FIXPLANTSTATE FixState;
+
+	FIXPID FixPID;
+
+	FIXPIDSTATE FixCtrl;
+
+	FIXERROR ErrFloat = {0}, ErrFixed = {0};
+
+	int32_t iR, iY, iU = 0;
+
+	double lfY, lfStart, lfNs[3];
+
+	volatile double lfSink = 0;	// keeps the timed loops alive
+
+	unsigned i, j, n, uNbrReps;
+
+	if (LtiParseTF(SYS_NUM, SYS_DEN, &Model) != 0 || LtiDiscretize(&Model, SimSet->fTs, ZOH, &Disc) != 0)
+		return -1;
+
+	Coef = PIDCompile(PID, SimSet->fTs);
+
+	Case.sSimCase   = TUNED;
+	Case.sSetpoint  = fSetpoint * PREC;
+	Case.fStepAmp   = 0;
+	Case.fStepDelay = 0;
+	Case.PID        = *PID;
+	Case.Plant      = &Disc;
+
+	/* a constant saturated to its format would make a different loop */
+	if (FixPlantCompile(&Disc, Fmt, &FixPlant) != 0 || FixPIDCompile(&Coef, Fmt, &FixPID) != 0
+	    || FixConvert(fSetpoint, Fmt->uSigFrac, Fmt->uWordBits, "set-point", &iR) != 0)
+	{
+		printf("Error: the loop does not fit the fixed-point format %u:%u:%u!\n",
+		       Fmt->uWordBits, Fmt->uSigFrac, Fmt->uCoefFrac);
+		return -1;
+	}
+
+	n = SimSet->uNbrIter;
+
+	/* accuracy: the three loops in lockstep */
+	LoopInit(&Loop, &Case);
+	FixState = FixPlantInit();
+	FixCtrl  = FixPIDInit();
+
+	for (i = 0; i < n; i++)
+	{
+		lfY = RefStep(&Ref, &Disc, &Coef, fSetpoint, i > 0);
+
+		LoopStep(&Loop, SimSet);
+
+		iY = FixPlantStep(&FixState, &FixPlant, Fmt, iU);
+		if (i > 0)
+			iU = FixPIDCtrl(&FixCtrl, &FixPID, Fmt, iR, iY);
+
+		AddError(&ErrFloat, (double)Loop.sSysOut / PREC, lfY, (double)Loop.sSysIn / PREC, Ref.lfUin);
+		AddError(&ErrFixed, FixToFloat(iY, Fmt->uSigFrac), lfY, FixToFloat(iU, Fmt->uSigFrac), Ref.lfUin);
+	}
+
+	/* throughput: the same loops timed one after the other */
+	uNbrReps = max(FIX_BENCH_SAMPLES / max(n, 1), 1);
+
+	lfStart = WallClock();
+	for (j = 0; j < uNbrReps; j++)
+	{
+		memset(&Ref, 0, sizeof(Ref));
+		for (i = 0; i < n; i++)
+			lfSink += RefStep(&Ref, &Disc, &Coef, fSetpoint, i > 0);
+	}
+	lfNs[0] = (WallClock() - lfStart) * 1e9 / ((double)uNbrReps * n);
+
+	lfStart = WallClock();
+	for (j = 0; j < uNbrReps; j++)
+	{
+		LoopInit(&Loop, &Case);
+		for (i = 0; i < n; i++)
+		{
+			LoopStep(&Loop, SimSet);
+			lfSink += Loop.sSysOut;
+		}
+	}
+	lfNs[1] = (WallClock() - lfStart) * 1e9 / ((double)uNbrReps * n);
+
+	lfStart = WallClock();
+	for (j = 0; j < uNbrReps; j++)
+	{
+		FixState = FixPlantInit();
+		FixCtrl  = FixPIDInit();
+		iU       = 0;
+		for (i = 0; i < n; i++)
+		{
+			iY = FixPlantStep(&FixState, &FixPlant, Fmt, iU);
+			if (i > 0)
+				iU = FixPIDCtrl(&FixCtrl, &FixPID, Fmt, iR, iY);
+			lfSink += iY;
+		}
+	}
+	lfNs[2] = (WallClock() - lfStart) * 1e9 / ((double)uNbrReps * n);
+
+	printf("Fixed-point check: %u bit signals Q%u.%u, coefficients Q%u.%u, %u samples\n\n",
+	       Fmt->uWordBits, Fmt->uWordBits - 1 - Fmt->uSigFrac, Fmt->uSigFrac,
+	       31 - Fmt->uCoefFrac, Fmt->uCoefFrac, n);
+
+	printf("%-8s %12s %12s %12s %12s %12s\n", "path", "max|dy|", "rms dy", "max|du|", "rms du", "ns/sample");
+	printf("%-8s %12s %12s %12s %12s %12.1f\n", "double", "-", "-", "-", "-", lfNs[0]);
+	printf("%-8s %12.3e %12.3e %12.3e %12.3e %12.1f\n", "float",
+	       ErrFloat.lfYMax, sqrt(ErrFloat.lfYSq / n), ErrFloat.lfUMax, sqrt(ErrFloat.lfUSq / n), lfNs[1]);
+	printf("%-8s %12.3e %12.3e %12.3e %12.3e %12.1f\n", "fixed",
+	       ErrFixed.lfYMax, sqrt(ErrFixed.lfYSq / n), ErrFixed.lfUMax, sqrt(ErrFixed.lfUSq / n), lfNs[2]);
+
+	return 0;
+} // End: FixCheck()
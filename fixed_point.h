@@ -0,0 +1,71 @@
+#ifndef __FIXED_POINT_H__
+#define __FIXED_POINT_H__
+
+#include <stdint.h>
+
+#include "simulation.h"
+
+/* Q format of the integer path: signals (errors, commands, plant
+   outputs) are words of uWordBits bits with uSigFrac fraction bits,
+   coefficients are 32 bit words with uCoefFrac fraction bits.
+   Products are accumulated in 64 bits with uSigFrac + uCoefFrac
+   fraction bits and rounded back once per result. */
+typedef struct tagFixFormat {
+	unsigned char uWordBits;	// signal word length, 16 or 32
+	unsigned char uSigFrac;		// fraction bits of the signals
+	unsigned char uCoefFrac;	// fraction bits of the coefficients
+} FIXFORMAT;
+
+// PID constants (PIDCOEF) in coefficient format
+typedef struct tagFixPID {
+	int32_t iK;				// proportional gain
+	int32_t iKd1, iKd2;		// derivative filter pole and gain
+	int32_t iKi;			// integrator gain
+	int32_t iKt;			// anti-windup gain
+	int32_t iUMin, iUMax;	// command limits in signal format
+} FIXPID;
+
+// fixed-point PID controller memory
+typedef struct tagFixPIDState {
+	int64_t llI;		// integral part in accumulator format
+	int32_t iDOld;		// derivative part of the previous sample
+	int32_t iYOld;		// plant output of the previous sample
+} FIXPIDSTATE;
+
+// difference equation (LTIDISC) in coefficient format
+typedef struct tagFixPlant {
+	unsigned uOrder;					// order n
+	int32_t  iB[LTI_MAX_ORDER + 1];	// b0 ... bn
+	int32_t  iA[LTI_MAX_ORDER + 1];	// 1, a1 ... an
+	int32_t  iUMin, iUMax;				// input limits in signal format
+} FIXPLANT;
+
+// fixed-point plant memory (direct form I)
+typedef struct tagFixPlantState {
+	int32_t iU[LTI_MAX_ORDER + 1];	// u(k) ... u(k-n)
+	int32_t iY[LTI_MAX_ORDER + 1];	// -, y(k-1) ... y(k-n)
+} FIXPLANTSTATE;
+
+FIXFORMAT FixFormat (unsigned uWordBits);
+
+int FixParseFormat (const char *cFormat, FIXFORMAT *Fmt);
+
+int32_t FixFromFloat (double lfX, unsigned uFrac, unsigned uWordBits);
+
+double FixToFloat (int64_t llX, unsigned uFrac);
+
+int FixPIDCompile (const PIDCOEF *Coef, const FIXFORMAT *Fmt, FIXPID *PID);
+
+FIXPIDSTATE FixPIDInit (void);
+
+int32_t FixPIDCtrl (FIXPIDSTATE *Ctrl, const FIXPID *PID, const FIXFORMAT *Fmt, int32_t iR, int32_t iY);
+
+int FixPlantCompile (const LTIDISC *Disc, const FIXFORMAT *Fmt, FIXPLANT *Plant);
+
+FIXPLANTSTATE FixPlantInit (void);
+
+int32_t FixPlantStep (FIXPLANTSTATE *Plant, const FIXPLANT *Coef, const FIXFORMAT *Fmt, int32_t iUin);
+
+int FixCheck (const FIXFORMAT *Fmt, const PIDSET *PID, float fSetpoint, const SIMSET *SimSet);
+
+#endif // __FIXED_POINT_H__
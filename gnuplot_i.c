@@ -35,14 +35,35 @@
 #include <stdarg.h>
 #include <assert.h>
 
+#include <signal.h>
+#include <errno.h>
+
 #ifdef WIN32
 #include <io.h>
+#include <fcntl.h>
+#include <process.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
 #endif // #ifdef WIN32
 
 /*---------------------------------------------------------------------------
                                 Defines
  ---------------------------------------------------------------------------*/
 
+/** Length of a temporary file name including its directory */
+#define GP_TMP_NAME_LEN     512
+
+/*---------------------------------------------------------------------------
+                                Globals
+ ---------------------------------------------------------------------------*/
+
+/** Sessions that own temporary files, cleaned up on exit and on signals */
+static gnuplot_ctrl **  gp_registry = NULL ;
+static int              gp_nregistry = 0 ;
+static int              gp_registry_capacity = 0 ;
+static int              gp_cleanup_installed = 0 ;
+
 /*---------------------------------------------------------------------------
                           Prototype Functions
  ---------------------------------------------------------------------------*/
@@ -69,6 +90,18 @@ char const * gnuplot_tmpfile(gnuplot_ctrl * handle);
  */
 void gnuplot_plot_atmpfile(gnuplot_ctrl * handle, char const* tmp_filename, char const* title);
 
+/**
+ * Plot a temporary file of raw doubles.
+ *
+ * @param handle
+ * @param tmp_filename
+ * @param format   gnuplot binary format, e.g. "%double%double"
+ * @param columns  using specification, e.g. "1:2"
+ * @param title
+ */
+static void gnuplot_plot_abinfile(gnuplot_ctrl * handle, char const* tmp_filename,
+                                  char const* format, char const* columns, char const* title);
+
 /*---------------------------------------------------------------------------
                             Function codes
  ---------------------------------------------------------------------------*/
@@ -89,7 +122,6 @@ void gnuplot_plot_atmpfile(gnuplot_ctrl * handle, char const* tmp_filename, char
 gnuplot_ctrl * gnuplot_init(void)
 {
     gnuplot_ctrl *  handle ;
-    int i;
 
 #ifndef WIN32
     if (getenv("DISPLAY") == NULL) {
@@ -105,6 +137,10 @@ gnuplot_ctrl * gnuplot_init(void)
     handle->nplots = 0 ;
     gnuplot_setstyle(handle, "points") ;
     handle->ntmp = 0 ;
+    handle->ntmp_pool = 0 ;
+    handle->tmp_capacity = 0 ;
+    handle->tmp_filename_tbl = NULL ;
+    handle->binary = GP_BINARY_DEFAULT ;
 
     handle->gnucmd = popen("gnuplot", "w") ;
     if (handle->gnucmd == NULL) {
@@ -113,10 +149,6 @@ gnuplot_ctrl * gnuplot_init(void)
         return NULL ;
     }
 
-    for (i=0;i<GP_MAX_TMP_FILES; i++)
-    {
-        handle->tmp_filename_tbl[i] = NULL;
-    }
     return handle;
 }
 
@@ -136,20 +168,11 @@ gnuplot_ctrl * gnuplot_init(void)
 
 void gnuplot_close(gnuplot_ctrl * handle)
 {
-    int     i ;
-
     if (pclose(handle->gnucmd) == -1) {
         fprintf(stderr, "problem closing communication to gnuplot\n") ;
         return ;
     }
-    if (handle->ntmp) {
-        for (i=0 ; i<handle->ntmp ; i++) {
-            remove(handle->tmp_filename_tbl[i]) ;
-            free(handle->tmp_filename_tbl[i]);
-            handle->tmp_filename_tbl[i] = NULL;
-
-        }
-    }
+    gnuplot_remove_tmpfiles(handle) ;
     free(handle) ;
     return ;
 }
@@ -236,6 +259,22 @@ void gnuplot_setstyle(gnuplot_ctrl * h, char * plot_style)
 }
 
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Selects the data transfer of a gnuplot session.
+  @param    h       Gnuplot session control handle.
+  @param    binary  1 to send raw doubles, 0 to send text.
+  @return   void
+ */
+/*--------------------------------------------------------------------------*/
+
+void gnuplot_setbinary(gnuplot_ctrl * h, int binary)
+{
+    h->binary = (binary != 0) ;
+    return ;
+}
+
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief    Sets the x label of a gnuplot session.
@@ -283,15 +322,7 @@ void gnuplot_set_ylabel(gnuplot_ctrl * h, char * label)
 
 void gnuplot_resetplot(gnuplot_ctrl * h)
 {
-    int     i ;
-    if (h->ntmp) {
-        for (i=0 ; i<h->ntmp ; i++) {
-            remove(h->tmp_filename_tbl[i]) ;
-            free(h->tmp_filename_tbl[i]);
-            h->tmp_filename_tbl[i] = NULL;
-
-        }
-    }
+    /* the files stay in the pool and are rewritten by the next plots */
     h->ntmp = 0 ;
     h->nplots = 0 ;
     return ;
@@ -343,13 +374,22 @@ void gnuplot_plot_x(
 
     /* Open temporary file for output   */
     tmpfname = gnuplot_tmpfile(handle);
-    tmpfd = fopen(tmpfname, "w");
+    if (tmpfname == NULL) return ;
+    tmpfd = fopen(tmpfname, handle->binary ? "wb" : "w");
 
     if (tmpfd == NULL) {
         fprintf(stderr,"cannot create temporary file: exiting plot") ;
         return ;
     }
 
+    /* Binary mode: the array is the file image */
+    if (handle->binary) {
+        fwrite(d, sizeof(double), n, tmpfd) ;
+        fclose(tmpfd) ;
+        gnuplot_plot_abinfile(handle, tmpfname, "%double", "0:1", title);
+        return ;
+    }
+
     /* Write data to this file  */
     for (i=0 ; i<n ; i++) {
       fprintf(tmpfd, "%.18e\n", d[i]);
@@ -402,21 +442,38 @@ void gnuplot_plot_xy(
     char            *   title
 )
 {
-    int     i ;
+    int     i, j, m ;
     FILE*   tmpfd ;
     char const * tmpfname;
+    double  chunk[2*GP_BINARY_CHUNK] ;
 
     if (handle==NULL || x==NULL || y==NULL || (n<1)) return ;
 
     /* Open temporary file for output   */
     tmpfname = gnuplot_tmpfile(handle);
-    tmpfd = fopen(tmpfname, "w");
+    if (tmpfname == NULL) return ;
+    tmpfd = fopen(tmpfname, handle->binary ? "wb" : "w");
 
     if (tmpfd == NULL) {
         fprintf(stderr,"cannot create temporary file: exiting plot") ;
         return ;
     }
 
+    /* Binary mode: interleave x and y by chunks */
+    if (handle->binary) {
+        for (i=0 ; i<n ; i+=GP_BINARY_CHUNK) {
+            m = (n-i < GP_BINARY_CHUNK) ? n-i : GP_BINARY_CHUNK ;
+            for (j=0 ; j<m ; j++) {
+                chunk[2*j]   = x[i+j] ;
+                chunk[2*j+1] = y[i+j] ;
+            }
+            fwrite(chunk, sizeof(double), 2*m, tmpfd) ;
+        }
+        fclose(tmpfd) ;
+        gnuplot_plot_abinfile(handle, tmpfname, "%double%double", "1:2", title);
+        return ;
+    }
+
     /* Write data to this file  */
     for (i=0 ; i<n; i++) {
         fprintf(tmpfd, "%.18e %.18e\n", x[i], y[i]) ;
@@ -429,6 +486,69 @@ void gnuplot_plot_xy(
 
 
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Writes columns of doubles to a temporary file of the session.
+  @param    handle  Gnuplot session control handle.
+  @param    cols    Array of ncols pointers to n doubles each.
+  @param    ncols   Number of columns.
+  @param    n       Number of values per column.
+  @return   Name of the temporary file, NULL on error.
+ */
+/*--------------------------------------------------------------------------*/
+
+char const * gnuplot_write_columns(
+    gnuplot_ctrl    *   handle,
+    double const    **  cols,
+    int                 ncols,
+    int                 n
+)
+{
+    int     i, j, k, m ;
+    FILE*   tmpfd ;
+    char const * tmpfname;
+    double * chunk ;
+
+    if (handle==NULL || cols==NULL || ncols<1 || n<1) return NULL ;
+
+    tmpfname = gnuplot_tmpfile(handle);
+    if (tmpfname == NULL) return NULL ;
+    tmpfd = fopen(tmpfname, handle->binary ? "wb" : "w");
+
+    if (tmpfd == NULL) {
+        fprintf(stderr,"cannot create temporary file: exiting plot") ;
+        return NULL ;
+    }
+
+    if (handle->binary) {
+        chunk = (double*)malloc(sizeof(double) * ncols * GP_BINARY_CHUNK) ;
+        if (chunk == NULL) {
+            fclose(tmpfd) ;
+            return NULL ;
+        }
+        for (i=0 ; i<n ; i+=GP_BINARY_CHUNK) {
+            m = (n-i < GP_BINARY_CHUNK) ? n-i : GP_BINARY_CHUNK ;
+            for (j=0 ; j<m ; j++) {
+                for (k=0 ; k<ncols ; k++) {
+                    chunk[ncols*j+k] = cols[k][i+j] ;
+                }
+            }
+            fwrite(chunk, sizeof(double), ncols*m, tmpfd) ;
+        }
+        free(chunk) ;
+    } else {
+        for (i=0 ; i<n ; i++) {
+            for (k=0 ; k<ncols ; k++) {
+                fprintf(tmpfd, (k<ncols-1) ? "%.18e " : "%.18e\n", cols[k][i]) ;
+            }
+        }
+    }
+    fclose(tmpfd) ;
+
+    return tmpfname ;
+}
+
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief    Open a new session, plot a signal, close the session.
@@ -655,53 +775,246 @@ int gnuplot_write_multi_csv(
     return 0;
 }
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Deletes the temporary files of every registered session.
+  @return   void
+
+  Runs at exit and from the signal handlers, so it only uses unlink() /
+  remove() on names that are already known.
+ */
+/*--------------------------------------------------------------------------*/
+
+static void gnuplot_cleanup(void)
+{
+    int     i, j ;
+
+    for (i=0 ; i<gp_nregistry ; i++) {
+        for (j=0 ; j<gp_registry[i]->ntmp_pool ; j++) {
+#ifdef WIN32
+            remove(gp_registry[i]->tmp_filename_tbl[j]) ;
+#else
+            unlink(gp_registry[i]->tmp_filename_tbl[j]) ;
+#endif // #ifdef WIN32
+        }
+    }
+    return ;
+}
+
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Removes the temporary files on a fatal signal, then dies.
+  @param    sig Signal number.
+  @return   void
+ */
+/*--------------------------------------------------------------------------*/
+
+static void gnuplot_cleanup_signal(int sig)
+{
+    gnuplot_cleanup() ;
+    signal(sig, SIG_DFL) ;
+    raise(sig) ;
+}
+
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Adds a session to the cleanup registry.
+  @param    handle Gnuplot session control handle.
+  @return   0 on success, -1 on failure
+
+  The first registration installs the exit and signal handlers.
+ */
+/*--------------------------------------------------------------------------*/
+
+static int gnuplot_register(gnuplot_ctrl * handle)
+{
+    gnuplot_ctrl ** tbl ;
+
+    if (!gp_cleanup_installed) {
+        atexit(gnuplot_cleanup) ;
+        signal(SIGINT,  gnuplot_cleanup_signal) ;
+        signal(SIGTERM, gnuplot_cleanup_signal) ;
+        signal(SIGABRT, gnuplot_cleanup_signal) ;
+#ifdef SIGHUP
+        signal(SIGHUP,  gnuplot_cleanup_signal) ;
+#endif // #ifdef SIGHUP
+        gp_cleanup_installed = 1 ;
+    }
+
+    if (gp_nregistry == gp_registry_capacity) {
+        tbl = (gnuplot_ctrl**) realloc(gp_registry,
+                sizeof(gnuplot_ctrl*) * (gp_registry_capacity ? 2*gp_registry_capacity : 8)) ;
+        if (tbl == NULL) {
+            return -1 ;
+        }
+        gp_registry = tbl ;
+        gp_registry_capacity = gp_registry_capacity ? 2*gp_registry_capacity : 8 ;
+    }
+
+    gp_registry[gp_nregistry++] = handle ;
+    return 0 ;
+}
+
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Removes a session from the cleanup registry.
+  @param    handle Gnuplot session control handle.
+  @return   void
+ */
+/*--------------------------------------------------------------------------*/
+
+static void gnuplot_unregister(gnuplot_ctrl * handle)
+{
+    int     i ;
+
+    for (i=0 ; i<gp_nregistry ; i++) {
+        if (gp_registry[i] == handle) {
+            gp_registry[i] = gp_registry[--gp_nregistry] ;
+            return ;
+        }
+    }
+}
+
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Returns the directory for temporary files.
+  @return   Directory name without trailing separator.
+
+  Memory backed /dev/shm is used when it exists, otherwise the usual
+  temporary directory of the system.
+ */
+/*--------------------------------------------------------------------------*/
+
+static char const * gnuplot_tmpdir(void)
+{
+    char const *    dir ;
+
+#ifdef WIN32
+    if ((dir = getenv("TEMP")) != NULL || (dir = getenv("TMP")) != NULL) {
+        return dir ;
+    }
+    return "." ;
+#else
+    if (access("/dev/shm", W_OK) == 0) {
+        return "/dev/shm" ;
+    }
+    if ((dir = getenv("TMPDIR")) != NULL) {
+        return dir ;
+    }
+    return "/tmp" ;
+#endif // #ifdef WIN32
+}
+
+
 char const * gnuplot_tmpfile(gnuplot_ctrl * handle)
 {
-    static char const * tmp_filename_template = "gnuplot_tmpdatafile_XXXXXX";
     char *              tmp_filename = NULL;
-    int                 tmp_filelen = strlen(tmp_filename_template);
+    char **             tbl ;
+    int                 capacity ;
 
-#ifndef WIN32
+#ifdef WIN32
+    static unsigned     win_counter = 0 ;
+    int                 win_fd, i ;
+#else
     int                 unx_fd;
-#endif // #ifndef WIN32
+#endif // #ifdef WIN32
 
-    assert(handle->tmp_filename_tbl[handle->ntmp] == NULL);
+    /* Reuse a file released by gnuplot_resetplot() */
+    if (handle->ntmp < handle->ntmp_pool) {
+        return handle->tmp_filename_tbl[handle->ntmp++] ;
+    }
 
-    /* Open one more temporary file? */
-    if (handle->ntmp == GP_MAX_TMP_FILES - 1) {
-        fprintf(stderr,
-                "maximum # of temporary files reached (%d): cannot open more",
-                GP_MAX_TMP_FILES) ;
-        return NULL;
+    /* Grow the table */
+    if (handle->ntmp_pool == handle->tmp_capacity) {
+        capacity = handle->tmp_capacity ? 2*handle->tmp_capacity : GP_TMP_FILES_INIT ;
+        tbl = (char**) realloc(handle->tmp_filename_tbl, sizeof(char*) * capacity) ;
+        if (tbl == NULL) {
+            return NULL ;
+        }
+        handle->tmp_filename_tbl = tbl ;
+        handle->tmp_capacity = capacity ;
+    }
+
+    /* The first file puts the session under exit and signal cleanup */
+    if (handle->ntmp_pool == 0 && gnuplot_register(handle) != 0) {
+        return NULL ;
     }
 
-    tmp_filename = (char*) malloc(tmp_filelen+1);
+    tmp_filename = (char*) malloc(GP_TMP_NAME_LEN);
     if (tmp_filename == NULL)
     {
         return NULL;
     }
-    strcpy(tmp_filename, tmp_filename_template);
 
 #ifdef WIN32
-    if (_mktemp(tmp_filename) == NULL)
+    /* _mktemp() only has 26 names per template: number the files instead */
+    do {
+        snprintf(tmp_filename, GP_TMP_NAME_LEN, "%s/gnuplot_tmpdatafile_%d_%u",
+                 gnuplot_tmpdir(), _getpid(), win_counter++) ;
+        win_fd = _open(tmp_filename, _O_CREAT | _O_EXCL | _O_WRONLY, _S_IREAD | _S_IWRITE) ;
+    } while (win_fd == -1 && errno == EEXIST) ;
+
+    if (win_fd == -1)
     {
+        free(tmp_filename) ;
         return NULL;
     }
+    _close(win_fd) ;
+
+    /* gnuplot reads backslashes in quoted names as escapes */
+    for (i=0 ; tmp_filename[i] != '\0' ; i++) {
+        if (tmp_filename[i] == '\\') tmp_filename[i] = '/' ;
+    }
 #else // #ifdef WIN32
+    snprintf(tmp_filename, GP_TMP_NAME_LEN, "%s/gnuplot_tmpdatafile_XXXXXX", gnuplot_tmpdir()) ;
     unx_fd = mkstemp(tmp_filename);
     if (unx_fd == -1)
     {
+        free(tmp_filename) ;
         return NULL;
     }
     close(unx_fd);
-
 #endif // #ifdef WIN32
 
-    handle->tmp_filename_tbl[handle->ntmp] = tmp_filename;
+    handle->tmp_filename_tbl[handle->ntmp_pool++] = tmp_filename;
     handle->ntmp ++;
     return tmp_filename;
 }
 
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Deletes the temporary files of a gnuplot session.
+  @param    h Gnuplot session control handle.
+  @return   void
+ */
+/*--------------------------------------------------------------------------*/
+
+void gnuplot_remove_tmpfiles(gnuplot_ctrl * h)
+{
+    int     i ;
+
+    for (i=0 ; i<h->ntmp_pool ; i++) {
+        remove(h->tmp_filename_tbl[i]) ;
+        free(h->tmp_filename_tbl[i]);
+    }
+
+    if (h->ntmp_pool > 0) {
+        gnuplot_unregister(h) ;
+    }
+
+    free(h->tmp_filename_tbl) ;
+    h->tmp_filename_tbl = NULL ;
+    h->tmp_capacity = 0 ;
+    h->ntmp_pool = 0 ;
+    h->ntmp = 0 ;
+    return ;
+}
+
 void gnuplot_plot_atmpfile(gnuplot_ctrl * handle, char const* tmp_filename, char const* title)
 {
     char const *    cmd    = (handle->nplots > 0) ? "replot" : "plot";
@@ -713,4 +1026,15 @@ void gnuplot_plot_atmpfile(gnuplot_ctrl * handle, char const* tmp_filename, char
 }
 
 
+static void gnuplot_plot_abinfile(gnuplot_ctrl * handle, char const* tmp_filename,
+                                  char const* format, char const* columns, char const* title)
+{
+    char const *    cmd    = (handle->nplots > 0) ? "replot" : "plot";
+    title                  = (title == NULL)      ? "(none)" : title;
+    gnuplot_cmd(handle, "%s \"%s\" binary format=\"%s\" using %s title \"%s\" with %s",
+                  cmd, tmp_filename, format, columns, title, handle->pstyle) ;
+    handle->nplots++ ;
+    return ;
+}
+
 /* vim: set ts=4 et sw=4 tw=75 */
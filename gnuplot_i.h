@@ -30,8 +30,14 @@
  ---------------------------------------------------------------------------*/
 #include <stdio.h>
 
-/** Maximal number of simultaneous temporary files */
-#define GP_MAX_TMP_FILES    64
+/** Initial size of the temporary file table (it grows as needed) */
+#define GP_TMP_FILES_INIT   16
+
+/** Data transfer of new sessions: 1 raw doubles, 0 text */
+#define GP_BINARY_DEFAULT   1
+
+/** Number of points converted at once in binary transfers */
+#define GP_BINARY_CHUNK     4096
 
 /*---------------------------------------------------------------------------
                                 New Types
@@ -61,10 +67,17 @@ typedef struct _GNUPLOT_CTRL_ {
     /** Current plotting style */
     char      pstyle[32] ;
 
-    /** Pointer to table of names of temporary files */
-    char*      tmp_filename_tbl[GP_MAX_TMP_FILES] ;
-    /** Number of temporary files */
+    /** Table of names of temporary files (grows as needed) */
+    char**    tmp_filename_tbl ;
+    /** Number of temporary files used by the current plot */
     int       ntmp ;
+    /** Number of temporary files created (used or free for reuse) */
+    int       ntmp_pool ;
+    /** Size of the table */
+    int       tmp_capacity ;
+
+    /** Write temporary files as raw doubles instead of text */
+    int       binary ;
 } gnuplot_ctrl ;
 
 /*---------------------------------------------------------------------------
@@ -149,6 +162,21 @@ void gnuplot_cmd(gnuplot_ctrl *  handle, char const *  cmd, ...);
 /*--------------------------------------------------------------------------*/
 void gnuplot_setstyle(gnuplot_ctrl * h, char * plot_style);
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Selects the data transfer of a gnuplot session.
+  @param    h       Gnuplot session control handle.
+  @param    binary  1 to send raw doubles, 0 to send text.
+  @return   void
+
+  In binary mode the plot functions write their points to the temporary
+  file as native doubles and gnuplot reads them with
+  binary format="%double...". This avoids formatting and parsing about
+  50 bytes of text per point. Text mode is the original behaviour.
+ */
+/*--------------------------------------------------------------------------*/
+void gnuplot_setbinary(gnuplot_ctrl * h, int binary);
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief    Sets the x label of a gnuplot session.
@@ -181,11 +209,25 @@ void gnuplot_set_ylabel(gnuplot_ctrl * h, char * label);
   @return   void
 
   Resets a gnuplot session, i.e. the next plot will erase all previous
-  ones.
+  ones. The temporary files of the previous plots are kept and reused by
+  the next ones.
  */
 /*--------------------------------------------------------------------------*/
 void gnuplot_resetplot(gnuplot_ctrl * h);
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Deletes the temporary files of a gnuplot session.
+  @param    h Gnuplot session control handle.
+  @return   void
+
+  Removes every temporary file created for the session and frees the
+  file table. gnuplot_close() does this; it is only needed for handles
+  that are not closed with gnuplot_close().
+ */
+/*--------------------------------------------------------------------------*/
+void gnuplot_remove_tmpfiles(gnuplot_ctrl * h);
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief    Plots a 2d graph from a list of doubles.
@@ -258,6 +300,30 @@ void gnuplot_plot_xy(
 ) ;
 
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Writes columns of doubles to a temporary file of the session.
+  @param    handle  Gnuplot session control handle.
+  @param    cols    Array of ncols pointers to n doubles each.
+  @param    ncols   Number of columns.
+  @param    n       Number of values per column.
+  @return   Name of the temporary file, NULL on error.
+
+  The file holds one record per value: raw doubles in binary mode
+  (read with binary format="%<ncols>double"), else one text line.
+  Several plot commands can then share one upload, e.g. the panels
+  of a multiplot. The file belongs to the session like those of
+  gnuplot_plot_xy().
+ */
+/*--------------------------------------------------------------------------*/
+char const * gnuplot_write_columns(
+    gnuplot_ctrl    *   handle,
+    double const    **  cols,
+    int                 ncols,
+    int                 n
+) ;
+
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief    Open a new session, plot a signal, close the session.
@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "histogram.h"
+
+
+/**
+*  -------------------------------------------------------  *
+*  HISTBIN() returns the bin of a duration: HIST_SUB bins
+*  per power of two, so the relative resolution is the
+*  same from ns to sec.
+*  -------------------------------------------------------  *
+*/
+static unsigned HistBin (double lfNs)
+{
+	double lfBin;
+
+	if (lfNs < 1)
+		return 0;
+
+	lfBin = HIST_SUB * log2(lfNs);
+
+	return (lfBin >= HIST_BINS - 1) ? HIST_BINS - 1 : (unsigned)lfBin;
+} // End: HistBin()
+
+
+/**
+*  -------------------------------------------------------  *
+*  HISTINIT() empties a histogram.
+*
+*  Inputs:
+*     *Hist: histogram
+*  -------------------------------------------------------  *
+*/
+void HistInit (HISTOGRAM *Hist)
+{
+	memset(Hist, 0, sizeof(HISTOGRAM));
+
+} // End: HistInit()
+
+
+/**
+*  -------------------------------------------------------  *
+*  HISTADD() records one duration.
+*
+*  Inputs:
+*     *Hist: histogram
+*     lfNs : duration [ns]
+*  -------------------------------------------------------  *
+*/
+void HistAdd (HISTOGRAM *Hist, double lfNs)
+{
+	if (Hist->llNbr == 0 || lfNs < Hist->lfMin)
+		Hist->lfMin = lfNs;
+	if (Hist->llNbr == 0 || lfNs > Hist->lfMax)
+		Hist->lfMax = lfNs;
+
+	Hist->lfSum += lfNs;
+	Hist->llNbr++;
+	Hist->llCount[HistBin(lfNs)]++;
+
+} // End: HistAdd()
+
+
+/**
+*  -------------------------------------------------------  *
+*  HISTMERGE() adds the samples of another histogram, e.g.
+*  of another thread.
+*
+*  Inputs:
+*     *Hist : histogram
+*     *Other: histogram to add
+*  -------------------------------------------------------  *
+*/
+void HistMerge (HISTOGRAM *Hist, const HISTOGRAM *Other)
+{
+	unsigned i;
+
+	if (Other->llNbr == 0)
+		return;
+
+	if (Hist->llNbr == 0 || Other->lfMin < Hist->lfMin)
+		Hist->lfMin = Other->lfMin;
+	if (Hist->llNbr == 0 || Other->lfMax > Hist->lfMax)
+		Hist->lfMax = Other->lfMax;
+
+	Hist->lfSum += Other->lfSum;
+	Hist->llNbr += Other->llNbr;
+
+	for (i = 0; i < HIST_BINS; i++)
+		Hist->llCount[i] += Other->llCount[i];
+
+} // End: HistMerge()
+
+
+/**
+*  -------------------------------------------------------  *
+*  HISTPERCENTILE() returns a percentile of the recorded
+*  durations, to the resolution of a bin (the upper edge
+*  of the bin, at most the maximum).
+*
+*  Inputs:
+*     *Hist    : histogram
+*     lfPercent: percentile [0 100]
+*
+*  Outputs:
+*     lfNs: duration [ns], 0 if the histogram is empty
+*  -------------------------------------------------------  *
+*/
+double HistPercentile (const HISTOGRAM *Hist, double lfPercent)
+{
+	unsigned long long llRank, llSum = 0;
+
+	unsigned i;
+
+	double lfEdge;
+
+	if (Hist->llNbr == 0)
+		return 0;
+
+	llRank = ceil(lfPercent / 100 * Hist->llNbr);
+	if (llRank < 1)
+		llRank = 1;
+
+	for (i = 0; i < HIST_BINS; i++)
+	{
+		llSum += Hist->llCount[i];
+
+		if (llSum >= llRank)
+			break;
+	}
+
+	lfEdge = pow(2, (double)(i + 1) / HIST_SUB);
+
+	return (lfEdge < Hist->lfMax) ? lfEdge : Hist->lfMax;
+} // End: HistPercentile()
+
+
+/**
+*  -------------------------------------------------------  *
+*  HISTPRINT() prints the statistics of a histogram in us.
+*
+*  Inputs:
+*     *Hist: histogram
+*     cName: label of the line
+*  -------------------------------------------------------  *
+*/
+void HistPrint (const HISTOGRAM *Hist, const char *cName)
+{
+	if (Hist->llNbr == 0)
+	{
+		printf("%-12s no samples\n", cName);
+		return;
+	}
+
+	printf("%-12s n %.0f  min %.2f  mean %.2f  p50 %.2f  p99 %.2f  p99.9 %.2f  max %.2f [us]\n",
+	       cName, (double)Hist->llNbr, Hist->lfMin * 1e-3, Hist->lfSum / Hist->llNbr * 1e-3,
+	       HistPercentile(Hist, 50) * 1e-3, HistPercentile(Hist, 99) * 1e-3,
+	       HistPercentile(Hist, 99.9) * 1e-3, Hist->lfMax * 1e-3);
+
+} // End: HistPrint()
@@ -0,0 +1,24 @@
+#ifndef __HISTOGRAM_H__
+#define __HISTOGRAM_H__
+
+#define HIST_SUB    8     // bins per octave
+#define HIST_BINS   320   // 40 octaves of ns: 1 ns ... about 18 min
+
+// log-scale histogram of durations in ns
+typedef struct tagHistogram {
+	unsigned long long llCount[HIST_BINS];	// samples per bin
+	unsigned long long llNbr;				// number of samples
+	double lfMin, lfMax, lfSum;				// exact statistics [ns]
+} HISTOGRAM;
+
+void HistInit (HISTOGRAM *Hist);
+
+void HistAdd (HISTOGRAM *Hist, double lfNs);
+
+void HistMerge (HISTOGRAM *Hist, const HISTOGRAM *Other);
+
+double HistPercentile (const HISTOGRAM *Hist, double lfPercent);
+
+void HistPrint (const HISTOGRAM *Hist, const char *cName);
+
+#endif // __HISTOGRAM_H__
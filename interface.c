@@ -2,6 +2,7 @@
 #include "util_func.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /**
 *  -------------------------------------------------------  *
@@ -16,12 +17,13 @@
 */
 unsigned char UserInput (void)
 {
-	#define NbrSim   4
+	#define NbrSim   6
 	
 	int sel;
 		
 	printf("Select the simulation case:\n   1. Step response\n   2. Already tuned PID\n");
-	printf("   3. Manual tuning\n   4. Automatic tuning\n");
+	printf("   3. Manual tuning\n   4. Automatic tuning\n   5. PID gain sweep\n");
+	printf("   6. Optimized tuning\n");
 	scanf("%i", &sel);
 	fflush(stdin);
 	
@@ -103,4 +105,85 @@ void UserStop(void)
 } // End: UserStop;
 
 
-
+/**
+*  -------------------------------------------------------  *
+*  PARSECMDLINE() reads the command line options. Without
+*  options the program runs interactively.
+*
+*     -s <file>   run the cases of a scenario file
+*     -o <dir>    output directory of the scenario files
+*     -t <file>   relay auto-tune the plants of a scenario
+*                 file
+*     -j <n>      number of threads (default: all cores)
+*     -q <fmt>    fixed-point check of the tuned loop, fmt
+*                 is 16|32[:sig:coef], the word length and
+*                 the fraction bits of signals and coeffi-
+*                 cients
+*     -p <link>   run the plant in a server process, linked
+*                 by shm or socket
+*     -r <set>    run the auto-tuned loop in real time, set
+*                 is period_sec[:fifo_priority[:cpu]]
+*     -m <file>   run the loops of a scenario file together,
+*                 each at its own sampling time
+*     -i <file>   identify the plant from the step response
+*                 in a log file
+*
+*  Inputs:
+*     argc, argv: command line arguments
+*
+*  Outputs:
+*     Cmd: command line options
+*  -------------------------------------------------------  *
+*/
+CMDLINE ParseCmdLine (int argc, char *argv[])
+{
+	CMDLINE Cmd;
+	
+	int i;
+	
+	Cmd.cScenario   = NULL;
+	Cmd.cOutDir     = ".";
+	Cmd.uNbrThreads = 0;
+	Cmd.cFixFormat  = NULL;
+	Cmd.cTunePlants = NULL;
+	Cmd.cPlantLink  = NULL;
+	Cmd.cRealTime   = NULL;
+	Cmd.cMultiRate  = NULL;
+	Cmd.cIdentify   = NULL;
+	
+	for (i = 1; i < argc; i++)
+	{
+		if (i + 1 < argc && strcmp(argv[i], "-s") == 0)
+			Cmd.cScenario = argv[++i];
+		else if (i + 1 < argc && strcmp(argv[i], "-o") == 0)
+			Cmd.cOutDir = argv[++i];
+		else if (i + 1 < argc && strcmp(argv[i], "-j") == 0)
+			Cmd.uNbrThreads = atoi(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "-q") == 0)
+			Cmd.cFixFormat = argv[++i];
+		else if (i + 1 < argc && strcmp(argv[i], "-t") == 0)
+			Cmd.cTunePlants = argv[++i];
+		else if (i + 1 < argc && strcmp(argv[i], "-p") == 0)
+			Cmd.cPlantLink = argv[++i];
+		else if (i + 1 < argc && strcmp(argv[i], "-r") == 0)
+			Cmd.cRealTime = argv[++i];
+		else if (i + 1 < argc && strcmp(argv[i], "-m") == 0)
+			Cmd.cMultiRate = argv[++i];
+		else if (i + 1 < argc && strcmp(argv[i], "-i") == 0)
+			Cmd.cIdentify = argv[++i];
+		else
+		{
+			printf("Usage: %s [-s scenario_file [-o output_dir] [-j threads]]\n", argv[0]);
+			printf("       %s -t plant_file [-o output_dir] [-j threads]\n", argv[0]);
+			printf("       %s -q 16|32[:signal_fraction:coefficient_fraction]\n", argv[0]);
+			printf("       %s -p shm|socket\n", argv[0]);
+			printf("       %s -r period_sec[:fifo_priority[:cpu]]\n", argv[0]);
+			printf("       %s -m scenario_file\n", argv[0]);
+			printf("       %s -i log_file\n", argv[0]);
+			exit(0);
+		}
+	}
+	
+	return Cmd;
+	
+} // End: ParseCmdLine()
@@ -1,6 +1,21 @@
 #ifndef __INTERFACE_H__
 #define __INTERFACE_H__
 
+// command line options
+typedef struct tagCmdLine {
+	const char *cScenario;		// scenario file for the batch mode (-s)
+	const char *cOutDir;		// output directory of the batch mode (-o)
+	unsigned    uNbrThreads;	// number of threads (-j), 0 uses all processors
+	const char *cFixFormat;		// Q format of the fixed-point check (-q)
+	const char *cTunePlants;	// plant list of the batch auto-tuning (-t)
+	const char *cPlantLink;		// link to a plant server process (-p)
+	const char *cRealTime;		// real-time settings (-r)
+	const char *cMultiRate;		// loops of the multi-rate co-simulation (-m)
+	const char *cIdentify;		// log of a step response to identify (-i)
+} CMDLINE;
+
+CMDLINE ParseCmdLine (int argc, char *argv[]);
+
 unsigned char UserInput (void);
 
 void WelcomeText (void);
@@ -0,0 +1,235 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#ifndef WIN32
+#include <signal.h>
+#endif // #ifndef WIN32
+
+#include "live_plot.h"
+#include "util_func.h"
+
+
+/**
+*  -------------------------------------------------------  *
+*  LIVEPLOTOPEN() starts the gnuplot session that is used
+*  for all live plots of the program.
+*
+*  Inputs:
+*     lfPeriod: minimum time between refreshes [sec]
+*
+*  Outputs:
+*     Live: live plot session, NULL if gnuplot cannot be
+*           started
+*  -------------------------------------------------------  *
+*/
+LIVEPLOT *LivePlotOpen (double lfPeriod)
+{
+	LIVEPLOT *Live;
+
+#ifndef WIN32
+	/* a gnuplot that quits must not kill the simulation */
+	signal(SIGPIPE, SIG_IGN);
+#endif // #ifndef WIN32
+
+	Live = malloc(sizeof(LIVEPLOT));
+	if (Live == NULL)
+	{
+		puts("Error: memory allocaion failed!\n");
+		return NULL;
+	}
+
+	Live->Handle = gnuplot_init();
+	if (Live->Handle == NULL)
+	{
+		free(Live);
+		return NULL;
+	}
+
+	Live->lfPeriod = lfPeriod;
+	Live->bFailed  = FALSE;
+
+	gnuplot_cmd(Live->Handle, "set xlabel \"time [sec]\"");
+	gnuplot_cmd(Live->Handle, "set grid");
+
+	LivePlotReset(Live);
+
+	return Live;
+} // End: LivePlotOpen()
+
+
+/**
+*  -------------------------------------------------------  *
+*  LIVEPLOTRESET() prepares the session for a new run.
+*
+*  Inputs:
+*     *Live: live plot session
+*  -------------------------------------------------------  *
+*/
+void LivePlotReset (LIVEPLOT *Live)
+{
+	Live->uSent  = 0;
+	Live->lfLast = 0;
+
+} // End: LivePlotReset()
+
+
+/**
+*  -------------------------------------------------------  *
+*  LIVEPLOTSTACK() draws the $Run data block as the multi-
+*  plot of PlotData(): output and set-point, input, and
+*  the P, I and D parts if logged, on a shared time axis.
+*  The settings of the live plot are restored afterwards.
+*  -------------------------------------------------------  *
+*/
+static void LivePlotStack (FILE *Cmd, unsigned char bSetpoint, unsigned char bPID)
+{
+	fprintf(Cmd, "set multiplot layout %u,1\n", bPID ? 3 : 2);
+	fprintf(Cmd, "set lmargin 10\n");
+	fprintf(Cmd, "set format x \"\"\n");
+	fprintf(Cmd, "unset xlabel\n");
+
+	fprintf(Cmd, "set ylabel \"Output\"\n");
+	if (bSetpoint)
+		fprintf(Cmd, "plot $Run using 1:3 with lines title \"Output\", "
+		             "$Run using 1:4 with lines title \"Set-point\"\n");
+	else
+		fprintf(Cmd, "plot $Run using 1:3 with lines title \"Output\"\n");
+
+	if (!bPID)
+	{
+		fprintf(Cmd, "set format x\n");
+		fprintf(Cmd, "set xlabel \"time [sec]\"\n");
+	}
+	fprintf(Cmd, "set ylabel \"Input\"\n");
+	fprintf(Cmd, "plot $Run using 1:2 with lines title \"Input\"\n");
+
+	if (bPID)
+	{
+		fprintf(Cmd, "set format x\n");
+		fprintf(Cmd, "set xlabel \"time [sec]\"\n");
+		fprintf(Cmd, "set ylabel \"PID parts\"\n");
+		fprintf(Cmd, "plot $Run using 1:5 with lines title \"P\", "
+		             "$Run using 1:6 with lines title \"I\", "
+		             "$Run using 1:7 with lines title \"D\"\n");
+	}
+
+	fprintf(Cmd, "unset multiplot\n");
+
+	/* back to the single live panel */
+	fprintf(Cmd, "set lmargin -1\n");
+	fprintf(Cmd, "unset ylabel\n");
+	fprintf(Cmd, "set format x\n");
+	fprintf(Cmd, "set xlabel \"time [sec]\"\n");
+
+} // End: LivePlotStack()
+
+
+/**
+*  -------------------------------------------------------  *
+*  LIVEPLOTUPDATE() appends the samples that are new since
+*  the last call to the $Run data block of gnuplot and re-
+*  draws the plot. Nothing is done until the refresh pe-
+*  riod has passed, so it can be called at any rate. Each
+*  batch is downsampled to its share of DS_POINTS over the
+*  buffer capacity, keeping the samples chosen for the in-
+*  put or for the output. The refresh at the end of a run
+*  draws the whole run as stacked panels (LivePlotStack()).
+*
+*  Inputs:
+*     *Live   : live plot session
+*     *DataSet: trajectory buffer being filled
+*     bForce  : refresh regardless of the period (end of a
+*               run)
+*  -------------------------------------------------------  *
+*/
+void LivePlotUpdate (LIVEPLOT *Live, const DATASET *DataSet, unsigned char bForce)
+{
+	FILE *Cmd;
+
+	double lfNow;
+
+	unsigned i, j, n, uNew, uMax;
+
+	unsigned char bPID;
+
+	if (Live == NULL || Live->bFailed || DataSet->Length == 0 || (!bForce && Live->uSent >= DataSet->Length))
+		return;
+
+	lfNow = WallClock();
+
+	if (!bForce && lfNow - Live->lfLast < Live->lfPeriod)
+		return;
+
+	Cmd  = Live->Handle->gnucmd;
+	bPID = (DataSet->P != NULL && DataSet->I != NULL && DataSet->D != NULL);
+
+	/* the first batch of a run replaces the data block */
+	fprintf(Cmd, "set print $Run%s\n", (Live->uSent == 0) ? "" : " append");
+
+	uNew = DataSet->Length - Live->uSent;
+	/* at least 4 samples per series, so Downsample() always reduces */
+	uMax = max((unsigned)ceil((double)uNew * DS_POINTS / max(DataSet->Capacity, 1)), 8);
+	uMax = min(uMax, DS_POINTS);
+
+	if (PLOT_DOWNSAMPLE == DS_NONE || uNew <= uMax)
+		n = 0;
+	else
+	{
+		i = Live->uSent;
+		n = Downsample(PLOT_DOWNSAMPLE, DataSet->Time + i, DataSet->Input + i, uNew, uMax / 2, Live->uIdx[0]);
+		j = Downsample(PLOT_DOWNSAMPLE, DataSet->Time + i, DataSet->Output + i, uNew, uMax / 2, Live->uIdx[1]);
+		n = DsMerge(Live->uIdx[0], n, Live->uIdx[1], j, Live->uIdx[2]);
+	}
+
+	for (j = 0; j < ((n > 0) ? n : uNew); j++)
+	{
+		i = Live->uSent + ((n > 0) ? Live->uIdx[2][j] : j);
+
+		/* columns: time input output set-point P I D, with enough
+		   digits to keep 1 ms steps apart in long runs */
+		fprintf(Cmd, "print \"%.10g %.10g %.10g %.10g %.10g %.10g %.10g\"\n",
+		        DataSet->Time[i], DataSet->Input[i], DataSet->Output[i],
+		        (DataSet->Setpoint != NULL) ? DataSet->Setpoint[i] : 0,
+		        bPID ? DataSet->P[i] : 0, bPID ? DataSet->I[i] : 0, bPID ? DataSet->D[i] : 0);
+	}
+
+	fprintf(Cmd, "unset print\n");
+
+	if (bForce)
+		LivePlotStack(Cmd, (DataSet->Setpoint != NULL), bPID);
+	else
+		fprintf(Cmd, "plot $Run using 1:3 with lines title \"Output\", "
+		             "$Run using 1:4 with lines title \"Set-point\", "
+		             "$Run using 1:2 with lines title \"Input\"\n");
+	fflush(Cmd);
+
+	if (ferror(Cmd))
+	{
+		puts("Error: live plot lost the connection to gnuplot!\n");
+		Live->bFailed = TRUE;
+	}
+
+	Live->uSent  = DataSet->Length;
+	Live->lfLast = lfNow;
+
+} // End: LivePlotUpdate()
+
+
+/**
+*  -------------------------------------------------------  *
+*  LIVEPLOTCLOSE() ends the gnuplot session.
+*
+*  Inputs:
+*     *Live: live plot session
+*  -------------------------------------------------------  *
+*/
+void LivePlotClose (LIVEPLOT *Live)
+{
+	if (Live == NULL)
+		return;
+
+	gnuplot_close(Live->Handle);
+	free(Live);
+
+} // End: LivePlotClose()
@@ -0,0 +1,28 @@
+#ifndef __LIVE_PLOT_H__
+#define __LIVE_PLOT_H__
+
+#include "data_treatment.h"
+#include "gnuplot_i.h"
+
+#define LIVE_REFRESH   0.2   // minimum time between two refreshes [sec]
+#define LIVE_CHECK     64    // samples between two refresh checks
+
+// persistent gnuplot session fed while a simulation runs
+typedef struct tagLivePlot {
+	gnuplot_ctrl *Handle;		// gnuplot session
+	unsigned      uSent;		// samples of the run already sent
+	double        lfPeriod;		// minimum time between refreshes [sec]
+	double        lfLast;		// time of the last refresh
+	unsigned char bFailed;		// gnuplot is not reachable any more
+	unsigned      uIdx[3][DS_POINTS];	// downsampling: input, output, both
+} LIVEPLOT;
+
+LIVEPLOT *LivePlotOpen (double lfPeriod);
+
+void LivePlotReset (LIVEPLOT *Live);
+
+void LivePlotUpdate (LIVEPLOT *Live, const DATASET *DataSet, unsigned char bForce);
+
+void LivePlotClose (LIVEPLOT *Live);
+
+#endif // __LIVE_PLOT_H__
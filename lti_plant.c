@@ -0,0 +1,563 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "lti_plant.h"
+#include "simulation.h"
+#include "util_func.h"
+
+#define LTI_DIM   (LTI_MAX_ORDER + 1)   // size of the augmented matrices
+
+// cached discretization
+typedef struct tagLtiCacheEntry {
+	unsigned char bValid;
+	LTIMODEL      Model;
+	LTIDISC       Disc;
+} LTICACHEENTRY;
+
+static LTICACHEENTRY   LtiCache[LTI_CACHE_SIZE];
+static unsigned        uLtiCacheNext = 0;
+static pthread_mutex_t LtiCacheLock  = PTHREAD_MUTEX_INITIALIZER;
+
+
+/**
+*  -------------------------------------------------------  *
+*  MATMUL() multiplies two n x n matrices: C = A B.
+*  -------------------------------------------------------  *
+*/
+static void MatMul (unsigned n, double A[][LTI_DIM], double B[][LTI_DIM], double C[][LTI_DIM])
+{
+	double T[LTI_DIM][LTI_DIM];
+
+	unsigned i, j, k;
+
+	for (i = 0; i < n; i++)
+		for (j = 0; j < n; j++)
+		{
+			T[i][j] = 0;
+			for (k = 0; k < n; k++)
+				T[i][j] += A[i][k] * B[k][j];
+		}
+
+	for (i = 0; i < n; i++)
+		for (j = 0; j < n; j++)
+			C[i][j] = T[i][j];
+
+} // End: MatMul()
+
+
+/**
+*  -------------------------------------------------------  *
+*  MATINV() inverts an n x n matrix in place with Gauss-
+*  Jordan elimination and partial pivoting.
+*
+*  Outputs:
+*     0 on success, -1 if the matrix is singular
+*  -------------------------------------------------------  *
+*/
+static int MatInv (unsigned n, double A[][LTI_DIM])
+{
+	double X[LTI_DIM][LTI_DIM], lfPivot, lfTmp;
+
+	unsigned i, j, k, p;
+
+	for (i = 0; i < n; i++)
+		for (j = 0; j < n; j++)
+			X[i][j] = (i == j);
+
+	for (k = 0; k < n; k++)
+	{
+		/* pivot row */
+		p = k;
+		for (i = k + 1; i < n; i++)
+			if (fabs(A[i][k]) > fabs(A[p][k]))
+				p = i;
+
+		if (fabs(A[p][k]) < 1e-12)
+			return -1;
+
+		for (j = 0; j < n; j++)
+		{
+			lfTmp = A[k][j]; A[k][j] = A[p][j]; A[p][j] = lfTmp;
+			lfTmp = X[k][j]; X[k][j] = X[p][j]; X[p][j] = lfTmp;
+		}
+
+		lfPivot = A[k][k];
+		for (j = 0; j < n; j++)
+		{
+			A[k][j] /= lfPivot;
+			X[k][j] /= lfPivot;
+		}
+
+		for (i = 0; i < n; i++)
+		{
+			if (i == k)
+				continue;
+
+			lfTmp = A[i][k];
+			for (j = 0; j < n; j++)
+			{
+				A[i][j] -= lfTmp * A[k][j];
+				X[i][j] -= lfTmp * X[k][j];
+			}
+		}
+	}
+
+	for (i = 0; i < n; i++)
+		for (j = 0; j < n; j++)
+			A[i][j] = X[i][j];
+
+	return 0;
+} // End: MatInv()
+
+
+/**
+*  -------------------------------------------------------  *
+*  MATEXP() computes the matrix exponential of an n x n
+*  matrix in place by scaling and squaring of a Taylor
+*  series.
+*  -------------------------------------------------------  *
+*/
+static void MatExp (unsigned n, double A[][LTI_DIM])
+{
+	#define EXPTERMS   16   // Taylor terms after scaling
+
+	double E[LTI_DIM][LTI_DIM], T[LTI_DIM][LTI_DIM], lfNorm, lfRow;
+
+	unsigned i, j, k, uSquare = 0;
+
+	/* scale so that the norm is below 0.5 */
+	lfNorm = 0;
+	for (i = 0; i < n; i++)
+	{
+		lfRow = 0;
+		for (j = 0; j < n; j++)
+			lfRow += fabs(A[i][j]);
+		lfNorm = max(lfNorm, lfRow);
+	}
+
+	while (lfNorm > 0.5)
+	{
+		lfNorm /= 2;
+		uSquare++;
+	}
+
+	for (i = 0; i < n; i++)
+		for (j = 0; j < n; j++)
+		{
+			A[i][j] = ldexp(A[i][j], -(int)uSquare);
+			E[i][j] = (i == j);
+			T[i][j] = (i == j);
+		}
+
+	/* Taylor series */
+	for (k = 1; k <= EXPTERMS; k++)
+	{
+		MatMul(n, T, A, T);
+		for (i = 0; i < n; i++)
+			for (j = 0; j < n; j++)
+			{
+				T[i][j] /= k;
+				E[i][j] += T[i][j];
+			}
+	}
+
+	/* squaring */
+	for (k = 0; k < uSquare; k++)
+		MatMul(n, E, E, E);
+
+	for (i = 0; i < n; i++)
+		for (j = 0; j < n; j++)
+			A[i][j] = E[i][j];
+
+} // End: MatExp()
+
+
+/**
+*  -------------------------------------------------------  *
+*  LTIFROMTF() builds the controllable canonical state-
+*  space model of a proper transfer function
+*
+*           b0 s^m + ... + bm
+*  G(s) = ---------------------,  m <= n
+*           a0 s^n + ... + an
+*
+*  Inputs:
+*     lfNum  : numerator coefficients, highest power first
+*     uNbrNum: number of numerator coefficients (m + 1)
+*     lfDen  : denominator coefficients, highest power first
+*     uNbrDen: number of denominator coefficients (n + 1)
+*
+*  Outputs:
+*     *Model: state-space model
+*     0 on success, -1 on invalid transfer function
+*  -------------------------------------------------------  *
+*/
+int LtiFromTF (
+		   const double *lfNum,
+		   unsigned uNbrNum,
+		   const double *lfDen,
+		   unsigned uNbrDen,
+		   LTIMODEL *Model
+		   )
+{
+	double lfB[LTI_DIM], lfA[LTI_DIM];
+
+	unsigned i, n;
+
+	if (uNbrDen < 1 || uNbrDen > LTI_DIM || uNbrNum < 1 || uNbrNum > uNbrDen || fabs(lfDen[0]) < eps)
+	{
+		printf("Error: the transfer function must be proper and of order %d at most!\n", LTI_MAX_ORDER);
+		return -1;
+	}
+
+	memset(Model, 0, sizeof(LTIMODEL));
+
+	n = uNbrDen - 1;
+	Model->uOrder = n;
+
+	/* monic denominator and numerator padded to n + 1 terms */
+	for (i = 0; i <= n; i++)
+	{
+		lfA[i] = lfDen[i] / lfDen[0];
+		lfB[i] = (i + uNbrNum > n) ? lfNum[i + uNbrNum - n - 1] / lfDen[0] : 0;
+	}
+
+	Model->lfD = lfB[0];
+
+	for (i = 0; i < n; i++)
+	{
+		Model->lfA[0][i] = -lfA[i + 1];
+		if (i > 0)
+			Model->lfA[i][i - 1] = 1;
+
+		Model->lfC[i] = lfB[i + 1] - lfA[i + 1] * lfB[0];
+	}
+
+	if (n > 0)
+		Model->lfB[0] = 1;
+
+	return 0;
+} // End: LtiFromTF()
+
+
+/**
+*  -------------------------------------------------------  *
+*  PARSELIST() reads comma separated numbers.
+*  -------------------------------------------------------  *
+*/
+static unsigned ParseList (const char *cList, double *lfValues, unsigned uMax)
+{
+	char *cEnd;
+
+	unsigned n = 0;
+
+	while (n < uMax)
+	{
+		lfValues[n] = strtod(cList, &cEnd);
+		if (cEnd == cList)
+			break;
+
+		n++;
+		cList = cEnd;
+
+		if (*cList != ',')
+			break;
+		cList++;
+	}
+
+	return (*cList == '\0') ? n : 0;
+} // End: ParseList()
+
+
+/**
+*  -------------------------------------------------------  *
+*  LTIPARSETF() builds a model from comma separated numer-
+*  ator and denominator coefficients, e.g. "2,2" and
+*  "1,0.8,4.2,1.616".
+*
+*  Inputs:
+*     cNum: numerator coefficients, highest power first
+*     cDen: denominator coefficients, highest power first
+*
+*  Outputs:
+*     *Model: state-space model
+*     0 on success, -1 on invalid input
+*  -------------------------------------------------------  *
+*/
+int LtiParseTF (const char *cNum, const char *cDen, LTIMODEL *Model)
+{
+	double lfNum[LTI_DIM], lfDen[LTI_DIM];
+
+	unsigned uNbrNum, uNbrDen;
+
+	uNbrNum = ParseList(cNum, lfNum, LTI_DIM);
+	uNbrDen = ParseList(cDen, lfDen, LTI_DIM);
+
+	return LtiFromTF(lfNum, uNbrNum, lfDen, uNbrDen, Model);
+} // End: LtiParseTF()
+
+
+/**
+*  -------------------------------------------------------  *
+*  LTIDISCRETIZE() discretizes a continuous-time model and
+*  returns it as a difference equation.
+*
+*  ZOH     : [Ad Bd; 0 1] = expm([A B; 0 0] Ts)
+*  TUSTIN  : Ad = (I - A Ts/2)^-1 (I + A Ts/2)
+*            Bd = (I - A Ts/2)^-1 B Ts
+*            Cd = C (I - A Ts/2)^-1
+*            Dd = D + C Bd / 2
+*
+*  The transfer function of (Ad, Bd, Cd, Dd) follows from
+*  the Faddeev-LeVerrier recursion, which gives both the
+*  characteristic polynomial and the adjugate of zI - Ad.
+*
+*  Inputs:
+*     *Model : continuous-time model
+*     fTs    : sampling time
+*     sMethod: ZOH or TUSTIN
+*
+*  Outputs:
+*     *Disc: difference equation
+*     0 on success, -1 on failure
+*  -------------------------------------------------------  *
+*/
+int LtiDiscretize (const LTIMODEL *Model, float fTs, short sMethod, LTIDISC *Disc)
+{
+	double Ad[LTI_DIM][LTI_DIM], M[LTI_DIM][LTI_DIM], P[LTI_DIM][LTI_DIM];
+
+	double lfBd[LTI_DIM], lfCd[LTI_DIM], lfDd, lfTrace, lfCMB;
+
+	unsigned i, j, k, n;
+
+	n = Model->uOrder;
+
+	memset(Disc, 0, sizeof(LTIDISC));
+	Disc->uOrder  = n;
+	Disc->fTs     = fTs;
+	Disc->sMethod = sMethod;
+
+	if (fTs <= 0)
+	{
+		puts("Error: the sampling time must be positive!\n");
+		return -1;
+	}
+
+	switch (sMethod)
+	{
+	   case ZOH:
+	   	/* augmented matrix [A B; 0 0] Ts */
+	   	memset(M, 0, sizeof(M));
+	   	for (i = 0; i < n; i++)
+	   	{
+	   		for (j = 0; j < n; j++)
+	   			M[i][j] = Model->lfA[i][j] * fTs;
+	   		M[i][n] = Model->lfB[i] * fTs;
+	   	}
+
+	   	MatExp(n + 1, M);
+
+	   	for (i = 0; i < n; i++)
+	   	{
+	   		for (j = 0; j < n; j++)
+	   			Ad[i][j] = M[i][j];
+	   		lfBd[i] = M[i][n];
+	   		lfCd[i] = Model->lfC[i];
+	   	}
+
+	   	lfDd = Model->lfD;
+	   	break;
+
+	   case TUSTIN:
+	   	/* M = (I - A Ts/2)^-1 */
+	   	for (i = 0; i < n; i++)
+	   		for (j = 0; j < n; j++)
+	   			M[i][j] = (i == j) - Model->lfA[i][j] * fTs / 2;
+
+	   	if (MatInv(n, M) != 0)
+	   	{
+	   		puts("Error: the plant has a pole at 2/Ts, Tustin is not defined!\n");
+	   		return -1;
+	   	}
+
+	   	for (i = 0; i < n; i++)
+	   		for (j = 0; j < n; j++)
+	   			P[i][j] = (i == j) + Model->lfA[i][j] * fTs / 2;
+
+	   	MatMul(n, M, P, Ad);
+
+	   	lfDd = Model->lfD;
+	   	for (i = 0; i < n; i++)
+	   	{
+	   		lfBd[i] = 0;
+	   		lfCd[i] = 0;
+	   		for (j = 0; j < n; j++)
+	   		{
+	   			lfBd[i] += M[i][j] * Model->lfB[j] * fTs;
+	   			lfCd[i] += Model->lfC[j] * M[j][i];
+	   		}
+
+	   		lfDd += Model->lfC[i] * lfBd[i] / 2;
+	   	}
+	   	break;
+
+	   default:
+	   	puts("Error: unknown discretization method!\n");
+	   	return -1;
+	}
+
+	/* Faddeev-LeVerrier: M1 = I, Mk = Ad Mk-1 + a(k-1) I, ak = -tr(Ad Mk) / k */
+	Disc->lfA[0] = 1;
+	Disc->lfB[0] = lfDd;
+
+	for (i = 0; i < n; i++)
+		for (j = 0; j < n; j++)
+			M[i][j] = (i == j);
+
+	for (k = 1; k <= n; k++)
+	{
+		if (k > 1)
+		{
+			MatMul(n, Ad, M, M);
+			for (i = 0; i < n; i++)
+				M[i][i] += Disc->lfA[k - 1];
+		}
+
+		MatMul(n, Ad, M, P);
+
+		lfTrace = 0;
+		for (i = 0; i < n; i++)
+			lfTrace += P[i][i];
+
+		Disc->lfA[k] = -lfTrace / k;
+
+		/* numerator: C Mk Bd + Dd ak */
+		lfCMB = 0;
+		for (i = 0; i < n; i++)
+			for (j = 0; j < n; j++)
+				lfCMB += lfCd[i] * M[i][j] * lfBd[j];
+
+		Disc->lfB[k] = lfCMB + lfDd * Disc->lfA[k];
+	}
+
+	return 0;
+} // End: LtiDiscretize()
+
+
+/**
+*  -------------------------------------------------------  *
+*  LTIGETDISC() returns the discretization of a model for
+*  a sampling time and method. Results are cached, so the
+*  matrix work is only done once per (model, Ts, method).
+*  It is safe to call from several threads.
+*
+*  Inputs:
+*     *Model : continuous-time model
+*     fTs    : sampling time
+*     sMethod: ZOH or TUSTIN
+*
+*  Outputs:
+*     *Disc: difference equation
+*     0 on success, -1 on failure
+*  -------------------------------------------------------  *
+*/
+int LtiGetDisc (const LTIMODEL *Model, float fTs, short sMethod, LTIDISC *Disc)
+{
+	LTICACHEENTRY *Entry;
+
+	unsigned i;
+
+	int iStatus;
+
+	pthread_mutex_lock(&LtiCacheLock);
+
+	for (i = 0; i < LTI_CACHE_SIZE; i++)
+	{
+		Entry = &LtiCache[i];
+
+		if (Entry->bValid && Entry->Disc.fTs == fTs && Entry->Disc.sMethod == sMethod
+		    && memcmp(&Entry->Model, Model, sizeof(LTIMODEL)) == 0)
+		{
+			*Disc = Entry->Disc;
+			pthread_mutex_unlock(&LtiCacheLock);
+			return 0;
+		}
+	}
+
+	iStatus = LtiDiscretize(Model, fTs, sMethod, Disc);
+
+	if (iStatus == 0)
+	{
+		/* replace the oldest entry */
+		Entry = &LtiCache[uLtiCacheNext];
+		uLtiCacheNext = (uLtiCacheNext + 1) % LTI_CACHE_SIZE;
+
+		Entry->bValid = TRUE;
+		Entry->Model  = *Model;
+		Entry->Disc   = *Disc;
+	}
+
+	pthread_mutex_unlock(&LtiCacheLock);
+
+	return iStatus;
+} // End: LtiGetDisc()
+
+
+/**
+*  -------------------------------------------------------  *
+*  LTIINIT() initializes the memory of a discrete plant.
+*
+*  Outputs:
+*     State: plant state at rest
+*  -------------------------------------------------------  *
+*/
+LTISTATE LtiInit (void)
+{
+	LTISTATE State;
+
+	memset(&State, 0, sizeof(State));
+
+	return State;
+} // End: LtiInit()
+
+
+/**
+*  -------------------------------------------------------  *
+*  LTISTEP() computes the output of a discrete plant and
+*  stores its input, like Sys2ndOrder() does for the fix-
+*  ed plant.
+*
+*  Inputs:
+*     *State: pointer to the plant state
+*     *Disc : difference equation of the plant
+*     sUin  : plant input
+*
+*  Outputs:
+*     sYout: plant output
+*  -------------------------------------------------------  *
+*/
+short LtiStep (LTISTATE *State, const LTIDISC *Disc, short sUin)
+{
+	double lfU, lfY;
+
+	unsigned i, n;
+
+	n = Disc->uOrder;
+
+	lfU = (double)sUin / PREC;
+	lfU = sat(lfU, UMIN, UMAX);
+
+	/* transposed direct form II */
+	lfY = Disc->lfB[0] * lfU + State->lfZ[0];
+
+	for (i = 0; i + 1 < n; i++)
+		State->lfZ[i] = State->lfZ[i + 1] + Disc->lfB[i + 1] * lfU - Disc->lfA[i + 1] * lfY;
+
+	if (n > 0)
+		State->lfZ[n - 1] = Disc->lfB[n] * lfU - Disc->lfA[n] * lfY;
+
+	return lfY * PREC;
+} // End: LtiStep()
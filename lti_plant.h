@@ -0,0 +1,49 @@
+#ifndef __LTI_PLANT_H__
+#define __LTI_PLANT_H__
+
+#define LTI_MAX_ORDER   8    // maximum plant order
+#define LTI_CACHE_SIZE  32   // number of cached discretizations
+
+enum C2dMethod
+{
+	ZOH,		// 0: zero-order hold
+	TUSTIN	// 1: bilinear transformation
+};
+
+// continuous-time plant in state-space form:  dx/dt = A x + B u,  y = C x + D u
+typedef struct tagLtiModel {
+	unsigned uOrder;									// number of states
+	double   lfA[LTI_MAX_ORDER][LTI_MAX_ORDER];
+	double   lfB[LTI_MAX_ORDER];
+	double   lfC[LTI_MAX_ORDER];
+	double   lfD;
+} LTIMODEL;
+
+/* discrete-time plant as a difference equation:
+   y(k) = b0 u(k) + ... + bn u(k-n) - a1 y(k-1) - ... - an y(k-n) */
+typedef struct tagLtiDisc {
+	unsigned uOrder;					// order n
+	float    fTs;						// sampling time
+	short    sMethod;					// ZOH or TUSTIN
+	double   lfB[LTI_MAX_ORDER + 1];	// b0 ... bn
+	double   lfA[LTI_MAX_ORDER + 1];	// 1, a1 ... an
+} LTIDISC;
+
+// plant memory (transposed direct form II)
+typedef struct tagLtiState {
+	double lfZ[LTI_MAX_ORDER];
+} LTISTATE;
+
+int LtiFromTF (const double *lfNum, unsigned uNbrNum, const double *lfDen, unsigned uNbrDen, LTIMODEL *Model);
+
+int LtiParseTF (const char *cNum, const char *cDen, LTIMODEL *Model);
+
+int LtiDiscretize (const LTIMODEL *Model, float fTs, short sMethod, LTIDISC *Disc);
+
+int LtiGetDisc (const LTIMODEL *Model, float fTs, short sMethod, LTIDISC *Disc);
+
+LTISTATE LtiInit (void);
+
+short LtiStep (LTISTATE *State, const LTIDISC *Disc, short sUin);
+
+#endif // __LTI_PLANT_H__
@@ -1,20 +1,158 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include "simulation.h"
 #include "util_func.h"
 #include "interface.h"
+#include "data_treatment.h"
+#include "sweep.h"
+#include "opt_tune.h"
+#include "scenario.h"
+#include "tune_batch.h"
+#include "fixed_point.h"
+#include "live_plot.h"
+#include "plant_server.h"
+#include "rt_loop.h"
+#include "async_log.h"
+#include "multirate.h"
+#include "sysid.h"
 
-int main ()
+int main (int argc, char *argv[])
 {
 	short sSimCase;
 	
+	int iStatus;
+	
 	char *cFileName;
 	
-	/* provide a file name to save simulation data into*/
+	DATASET Traj;
+	
+	CMDLINE Cmd;
+	
+	SCENARIO *Cases;
+	
+	unsigned uNbrCases;
+	
+	FIXFORMAT Fmt;
+	
+	PIDSET PID;
+	
+	LIVEPLOT *Live;
+	
+	RTSET RtSet;
+	
+	RTSTATS RtStats;
+	
+	/* headless mode: run a scenario file and quit */
+	Cmd = ParseCmdLine(argc, argv);
+	
+	if (Cmd.cScenario != NULL)
+	{
+		if (ScenarioRead(Cmd.cScenario, &Cases, &uNbrCases) != 0)
+			return 1;
+		
+		iStatus = ScenarioRun(Cases, uNbrCases, Cmd.cOutDir, Cmd.uNbrThreads);
+		free(Cases);
+		
+		return iStatus != 0;
+	}
+	
+	/* headless mode: relay auto-tune a list of plants and quit */
+	if (Cmd.cTunePlants != NULL)
+		return TuneBatchRun(Cmd.cTunePlants, Cmd.cOutDir, Cmd.uNbrThreads) != 0;
+	
+	/* headless mode: run many loops at their own rates and quit */
+	if (Cmd.cMultiRate != NULL)
+		return MrSession(Cmd.cMultiRate) != 0;
+	
+	/* headless mode: identify a plant model from a logged step and quit */
+	if (Cmd.cIdentify != NULL)
+		return SysIdRun(Cmd.cIdentify) != 0;
+	
+	/* tuned loop with the plant in a server process and quit */
+	if (Cmd.cPlantLink != NULL)
+	{
+		if (strcmp(Cmd.cPlantLink, "shm") != 0 && strcmp(Cmd.cPlantLink, "socket") != 0)
+		{
+			printf("Error: invalid plant link %s!\n", Cmd.cPlantLink);
+			return 1;
+		}
+		
+		TunedPID(&PID);
+		
+		return PlantServerRun((strcmp(Cmd.cPlantLink, "shm") == 0) ? PS_SHM : PS_SOCKET, &PID, 1, PS_SAMPLES) != 0;
+	}
+	
+	/* auto-tuned loop paced in real time and quit */
+	if (Cmd.cRealTime != NULL)
+	{
+		if (RtParseSet(Cmd.cRealTime, &RtSet) != 0)
+		{
+			printf("Error: invalid real-time settings %s!\n", Cmd.cRealTime);
+			return 1;
+		}
+		
+		SIMSET SimSet = SimInit(SIMTIME);
+		SimSet.uNbrIter = RT_SAMPLES;
+		
+		CASESET Case;
+		
+		Case.sSimCase   = AUTO;
+		Case.sSetpoint  = PREC;
+		Case.fStepAmp   = 0;
+		Case.fStepDelay = 0;
+		Case.Plant      = NULL;
+		TunedPID(&Case.PID);
+		
+		const char *cChanNames[DATA_NBR_CHAN] = {"time", "input", "output", "setpoint", "P", "I", "D"};
+		
+		ASYNCLOG *ALog = AsyncLogOpen("rt_data.dat", SimSet.fTs, SimSet.uNbrIter, DATA_NBR_CHAN, cChanNames);
+		
+		RtSetup(&RtSet);
+		
+		if (RtRun(&RtSet, &SimSet, &Case, ALog, &RtStats) != 0)
+			return 1;
+		
+		RtReport(&RtSet, &RtStats);
+		
+		if (ALog != NULL)
+		{
+			AsyncLogReport(ALog);
+			AsyncLogClose(ALog);
+		}
+		
+		return 0;
+	}
+	
+	/* fixed-point check of the tuned loop and quit */
+	if (Cmd.cFixFormat != NULL)
+	{
+		if (FixParseFormat(Cmd.cFixFormat, &Fmt) != 0)
+		{
+			printf("Error: invalid fixed-point format %s!\n", Cmd.cFixFormat);
+			return 1;
+		}
+		
+		SIMSET SimSet = SimInit(SIMTIME);
+		
+		TunedPID(&PID);
+		
+		return FixCheck(&Fmt, &PID, 1, &SimSet) != 0;
+	}
+	
+	/* provide a file name to save simulation data into (NULL: no file) */
 	cFileName = "sim_data.dat";
 	
 	WelcomeText();
 	
+	/* trajectory buffer reused by every simulation */
+	if (DataSetAlloc(&Traj, SimInit(SIMTIME).uNbrIter, TRUE) != 0)
+		return 1;
+	
+	/* one gnuplot session shows every run while it goes on */
+	Live = LivePlotOpen(LIVE_REFRESH);
+	
 	while(1)
 	{
 		/* simulation initialization */
@@ -23,11 +161,29 @@ int main ()
 		/* receive user command */
 		sSimCase = UserInput();
 		
-		/* main simulation loop */
-		simulation(&SimSet, sSimCase, cFileName);
-		
-		/* plot data from a file */
-		PlotData(cFileName, SimSet.uNbrIter);
+		if (sSimCase == SWEEP)
+		{
+			/* score a grid of PID gains */
+			SweepSession(&SimSet);
+		}
+		else if (sSimCase == OPTIMIZE)
+		{
+			/* search the PID gains minimizing a closed-loop cost */
+			OptTuneSession(&SimSet);
+		}
+		else
+		{
+			/* main simulation loop */
+			simulation(&SimSet, sSimCase, &Traj, cFileName, Live);
+			
+			/* plot data from memory if there is no live plot */
+			if (Live == NULL || Live->bFailed)
+				PlotData(&Traj);
+			
+			/* open-loop step: fit a plant model and suggest gains */
+			if (sSimCase == STEP)
+				SysIdReport(&Traj);
+		}
 		
 		/* check if user wants to stop */
 		UserStop();
@@ -0,0 +1,110 @@
+#include <math.h>
+
+#include "metrics.h"
+#include "util_func.h"
+
+
+/**
+*  -------------------------------------------------------  *
+*  METRICSINIT() prepares the performance metrics of a
+*  set-point response.
+*
+*  Inputs:
+*     *Metrics : pointer to the metrics
+*     fSetpoint: set-point
+*  -------------------------------------------------------  *
+*/
+void MetricsInit (METRICS *Metrics, float fSetpoint)
+{
+	Metrics->fIAE        = 0;
+	Metrics->fISE        = 0;
+	Metrics->fITAE       = 0;
+	Metrics->fOvershoot  = 0;
+	Metrics->fRiseTime   = 0;
+	Metrics->fSettleTime = 0;
+	
+	Metrics->fR     = fSetpoint;
+	Metrics->fYPeak = 0;
+	Metrics->fT10   = -1;
+	Metrics->fT90   = -1;
+	Metrics->fTOut  = -1;
+	Metrics->fTime  = 0;
+	
+} // End: MetricsInit()
+
+
+/**
+*  -------------------------------------------------------  *
+*  METRICSUPDATE() accumulates one sample of the response,
+*  so no trajectory has to be stored.
+*
+*  Inputs:
+*     *Metrics: pointer to the metrics
+*     fTime   : current time instant
+*     fY      : plant output
+*     fTs     : sampling time
+*  -------------------------------------------------------  *
+*/
+void MetricsUpdate (METRICS *Metrics, float fTime, float fY, float fTs)
+{
+	float fError, fAbsError, fScale, fYn;
+	
+	fError    = Metrics->fR - fY;
+	fAbsError = fabs(fError);
+	
+	/* error integrals */
+	Metrics->fIAE  += fAbsError * fTs;
+	Metrics->fISE  += fError * fError * fTs;
+	Metrics->fITAE += fTime * fAbsError * fTs;
+	
+	/* output normalized by the set-point */
+	fScale = (fabs(Metrics->fR) > eps) ? Metrics->fR : 1;
+	fYn    = fY / fScale;
+	
+	if (fYn > Metrics->fYPeak)
+		Metrics->fYPeak = fYn;
+	
+	if (Metrics->fT10 < 0 && fYn >= 0.1)
+		Metrics->fT10 = fTime;
+	
+	if (Metrics->fT90 < 0 && fYn >= 0.9)
+		Metrics->fT90 = fTime;
+	
+	if (fabs(fYn - 1) * 100 > SETTLEBAND)
+		Metrics->fTOut = fTime;
+	
+	Metrics->fTime = fTime;
+	
+} // End: MetricsUpdate()
+
+
+/**
+*  -------------------------------------------------------  *
+*  METRICSFINISH() concludes the metrics at the end of the
+*  response. A rise or settling that did not happen with-
+*  in the horizon is reported as the horizon length.
+*
+*  Inputs:
+*     *Metrics: pointer to the metrics
+*     fTs     : sampling time
+*  -------------------------------------------------------  *
+*/
+void MetricsFinish (METRICS *Metrics, float fTs)
+{
+	float fHorizon;
+	
+	fHorizon = Metrics->fTime + fTs;
+	
+	Metrics->fOvershoot = max(0, (Metrics->fYPeak - 1) * 100);
+	
+	if (Metrics->fT90 >= 0)
+		Metrics->fRiseTime = Metrics->fT90 - Metrics->fT10;
+	else
+		Metrics->fRiseTime = fHorizon;
+	
+	if (Metrics->fTOut >= 0)
+		Metrics->fSettleTime = Metrics->fTOut + fTs;
+	else
+		Metrics->fSettleTime = 0;
+	
+} // End: MetricsFinish()
@@ -0,0 +1,29 @@
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#define SETTLEBAND   2     // settling band in percent of the set-point
+
+// closed-loop performance of a set-point response
+typedef struct tagMetrics {
+	float fIAE;			// integral of absolute error
+	float fISE;			// integral of squared error
+	float fITAE;			// integral of time weighted absolute error
+	float fOvershoot;	// maximum overshoot [%]
+	float fRiseTime;		// 10% to 90% rise time [sec]
+	float fSettleTime;	// settling time into the SETTLEBAND [sec]
+
+	/* running values */
+	float fR;				// set-point
+	float fYPeak;		// peak of the normalized output
+	float fT10, fT90;	// first time at 10% and 90% of the set-point
+	float fTOut;			// last time outside the settling band
+	float fTime;			// time of the last sample
+} METRICS;
+
+void MetricsInit (METRICS *Metrics, float fSetpoint);
+
+void MetricsUpdate (METRICS *Metrics, float fTime, float fY, float fTs);
+
+void MetricsFinish (METRICS *Metrics, float fTs);
+
+#endif // __METRICS_H__
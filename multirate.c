@@ -0,0 +1,321 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "multirate.h"
+#include "util_func.h"
+
+
+/**
+*  -------------------------------------------------------  *
+*  GCD() returns the greatest common divisor of a and b.
+*  -------------------------------------------------------  *
+*/
+static unsigned long long Gcd (unsigned long long a, unsigned long long b)
+{
+	unsigned long long t;
+
+	while (b != 0)
+	{
+		t = a % b;
+		a = b;
+		b = t;
+	}
+
+	return a;
+} // End: Gcd()
+
+
+/**
+*  -------------------------------------------------------  *
+*  MRCOMPARE() orders loops by period for qsort().
+*  -------------------------------------------------------  *
+*/
+static int MrCompare (const void *pA, const void *pB)
+{
+	const MRLOOP *A = pA, *B = pB;
+
+	return (A->llPeriod > B->llPeriod) - (A->llPeriod < B->llPeriod);
+} // End: MrCompare()
+
+
+/**
+*  -------------------------------------------------------  *
+*  MRINIT() prepares the loops of a set of cases for the
+*  multi-rate executor. Every loop runs at its own samp-
+*  ling time Ts with its plant discretized at that rate
+*  (the built-in plant only at SAMPLINGTIME). Loops of the
+*  same period form a group that is stepped together.
+*
+*  Inputs:
+*     *Cases    : loops, as read by ScenarioRead()
+*     uNbrCases : number of loops
+*
+*  Outputs:
+*     *Sched: executor at time 0 (free with MrFree())
+*     0 on success, -1 on failure
+*  -------------------------------------------------------  *
+*/
+int MrInit (MRSCHED *Sched, const SCENARIO *Cases, unsigned uNbrCases)
+{
+	MRLOOP *L;
+
+	CASESET Case;
+
+	unsigned long long llGcd;
+
+	unsigned i, g;
+
+	float fReference;
+
+	Sched->Loops      = calloc(uNbrCases, sizeof(MRLOOP));
+	Sched->Groups     = calloc(uNbrCases, sizeof(MRGROUP));
+	Sched->uNbrLoops  = uNbrCases;
+	Sched->uNbrGroups = 0;
+	Sched->llNow      = 0;
+	Sched->llSteps    = 0;
+
+	if (Sched->Loops == NULL || Sched->Groups == NULL)
+	{
+		puts("Error: memory allocaion failed!\n");
+		MrFree(Sched);
+		return -1;
+	}
+
+	for (i = 0; i < uNbrCases; i++)
+	{
+		L = &Sched->Loops[i];
+
+		L->Scn             = &Cases[i];
+		L->SimSet.fTs      = Cases[i].fTs;
+		L->SimSet.uNbrIter = Cases[i].fTsim / Cases[i].fTs;
+		L->llPeriod        = (unsigned long long)(Cases[i].fTs / MR_RESOLUTION + 0.5);
+
+		if (L->llPeriod == 0)
+		{
+			printf("Error: %s samples faster than the timeline resolution!\n", Cases[i].cName);
+			MrFree(Sched);
+			return -1;
+		}
+	}
+
+	/* the plants are referenced from the loops, so sort first */
+	qsort(Sched->Loops, uNbrCases, sizeof(MRLOOP), MrCompare);
+
+	llGcd = 0;
+	Sched->llHyper = 1;
+
+	for (i = 0; i < uNbrCases; i++)
+	{
+		L = &Sched->Loops[i];
+
+		Case       = L->Scn->Case;
+		Case.Plant = NULL;
+
+		if (L->Scn->bModel)
+		{
+			if (LtiGetDisc(&L->Scn->Model, L->Scn->fTs, L->Scn->sMethod, &L->Disc) != 0)
+			{
+				printf("Error: the plant of %s cannot be discretized!\n", L->Scn->cName);
+				MrFree(Sched);
+				return -1;
+			}
+
+			Case.Plant = &L->Disc;
+		}
+
+		LoopInit(&L->Loop, &Case);
+
+		/* step cases are scored against the step size */
+		fReference = (Case.sSimCase == STEP) ? Case.fStepAmp : (float)Case.sSetpoint / PREC;
+		MetricsInit(&L->Metrics, fReference);
+
+		/* groups of equal periods */
+		if (i == 0 || L->llPeriod != Sched->Loops[i - 1].llPeriod)
+		{
+			g = Sched->uNbrGroups++;
+
+			Sched->Groups[g].llPeriod = L->llPeriod;
+			Sched->Groups[g].llNext   = 0;
+			Sched->Groups[g].uFirst   = i;
+			Sched->Groups[g].uNbr     = 0;
+
+			/* lcm, 0 once it overflows */
+			llGcd = Gcd(llGcd, L->llPeriod);
+			if (Sched->llHyper != 0)
+			{
+				Sched->llHyper /= Gcd(Sched->llHyper, L->llPeriod);
+				Sched->llHyper  = (Sched->llHyper > ~0ULL / L->llPeriod) ? 0 : Sched->llHyper * L->llPeriod;
+			}
+		}
+
+		Sched->Groups[Sched->uNbrGroups - 1].uNbr++;
+	}
+
+	Sched->llTick = llGcd;
+
+	return 0;
+} // End: MrInit()
+
+
+/**
+*  -------------------------------------------------------  *
+*  MRRUN() advances the timeline to lfTime. The timeline
+*  jumps from one due time to the next, and at each of
+*  them only the groups that are due are stepped, the fa-
+*  stest first. A loop thus costs one step per own sample
+*  whatever the rates of the other loops, and it stops at
+*  its own horizon.
+*
+*  Inputs:
+*     *Sched: multi-rate executor
+*     lfTime: end of the run [sec]
+*  -------------------------------------------------------  *
+*/
+void MrRun (MRSCHED *Sched, double lfTime)
+{
+	unsigned long long llEnd, llNext;
+
+	unsigned g, i;
+
+	MRGROUP *G;
+
+	MRLOOP *L;
+
+	llEnd = (unsigned long long)(lfTime / MR_RESOLUTION + 0.5);
+
+	while (Sched->uNbrGroups > 0)
+	{
+		/* next due time */
+		llNext = Sched->Groups[0].llNext;
+		for (g = 1; g < Sched->uNbrGroups; g++)
+			llNext = min(llNext, Sched->Groups[g].llNext);
+
+		if (llNext >= llEnd)
+			break;
+
+		Sched->llNow = llNext;
+
+		for (g = 0; g < Sched->uNbrGroups; g++)
+		{
+			G = &Sched->Groups[g];
+
+			if (G->llNext != llNext)
+				continue;
+
+			for (i = G->uFirst; i < G->uFirst + G->uNbr; i++)
+			{
+				L = &Sched->Loops[i];
+
+				if (L->Loop.uIter >= L->SimSet.uNbrIter)
+					continue;
+
+				LoopStep(&L->Loop, &L->SimSet);
+				MetricsUpdate(&L->Metrics, (L->Loop.uIter - 1) * L->SimSet.fTs,
+				              (float)L->Loop.sSysOut / PREC, L->SimSet.fTs);
+
+				Sched->llSteps++;
+			}
+
+			G->llNext += G->llPeriod;
+		}
+	}
+
+} // End: MrRun()
+
+
+/**
+*  -------------------------------------------------------  *
+*  MRFREE() releases the loops of the executor.
+*
+*  Inputs:
+*     *Sched: multi-rate executor
+*  -------------------------------------------------------  *
+*/
+void MrFree (MRSCHED *Sched)
+{
+	free(Sched->Loops);
+	free(Sched->Groups);
+
+	Sched->Loops      = NULL;
+	Sched->Groups     = NULL;
+	Sched->uNbrLoops  = 0;
+	Sched->uNbrGroups = 0;
+
+} // End: MrFree()
+
+
+/**
+*  -------------------------------------------------------  *
+*  MRSESSION() co-simulates every loop of a scenario file
+*  on one timeline, each at its own Ts and up to its own
+*  horizon T, and prints the result of every
+*  loop and the work of the executor.
+*
+*  Inputs:
+*     cFileName: loops in the scenario file format
+*
+*  Outputs:
+*     0 on success, -1 on failure
+*  -------------------------------------------------------  *
+*/
+int MrSession (const char *cFileName)
+{
+	SCENARIO *Cases;
+
+	MRSCHED Sched;
+
+	MRLOOP *L;
+
+	double lfHorizon = 0, lfStart, lfElapsed, lfFastest = 0;
+
+	unsigned i, uNbrCases;
+
+	if (ScenarioRead(cFileName, &Cases, &uNbrCases) != 0)
+		return -1;
+
+	if (MrInit(&Sched, Cases, uNbrCases) != 0)
+	{
+		free(Cases);
+		return -1;
+	}
+
+	for (i = 0; i < uNbrCases; i++)
+		lfHorizon = max(lfHorizon, Cases[i].fTsim);
+
+	lfStart = WallClock();
+	MrRun(&Sched, lfHorizon);
+	lfElapsed = WallClock() - lfStart;
+
+	printf("%-16s %8s %8s | %8s %8s %8s | %8s %8s\n", "loop", "Ts [s]", "steps", "K", "Ti", "Td", "IAE", "OS [%]");
+
+	for (i = 0; i < Sched.uNbrLoops; i++)
+	{
+		L = &Sched.Loops[i];
+
+		MetricsFinish(&L->Metrics, L->SimSet.fTs);
+
+		printf("%-16s %8.4f %8u | %8.3f %8.3f %8.3f | %8.3f %8.2f\n",
+		       L->Scn->cName, L->SimSet.fTs, L->Loop.uIter, L->Loop.PID.K, L->Loop.PID.Ti, L->Loop.PID.Td,
+		       L->Metrics.fIAE, L->Metrics.fOvershoot);
+
+		/* a single-rate executor steps every loop at the fastest rate */
+		lfFastest += (unsigned)(L->Scn->fTsim / Sched.Loops[0].SimSet.fTs);
+	}
+
+	printf("\n%u loops in %u rate groups, tick %.6f sec, hyperperiod ", Sched.uNbrLoops, Sched.uNbrGroups,
+	       Sched.llTick * MR_RESOLUTION);
+
+	if (Sched.llHyper != 0)
+		printf("%.6f sec\n", Sched.llHyper * MR_RESOLUTION);
+	else
+		printf("too long\n");
+
+	printf("%.0f loop steps in %.3f sec (%.3g steps/sec), %.1f %% of a single-rate schedule\n",
+	       (double)Sched.llSteps, lfElapsed, Sched.llSteps / max(lfElapsed, eps), 100 * Sched.llSteps / lfFastest);
+
+	MrFree(&Sched);
+	free(Cases);
+
+	return 0;
+} // End: MrSession()
@@ -0,0 +1,46 @@
+#ifndef __MULTIRATE_H__
+#define __MULTIRATE_H__
+
+#include "scenario.h"
+
+#define MR_RESOLUTION   1e-6   // time resolution of the timeline [sec]
+
+// one loop hosted by the scheduler
+typedef struct tagMrLoop {
+	const SCENARIO *Scn;		// description of the loop
+	LOOP      Loop;			// plant, controller and tuner
+	SIMSET    SimSet;		// sampling time of the loop
+	LTIDISC   Disc;			// plant discretized at the loop rate
+	METRICS   Metrics;		// set-point response
+	unsigned long long llPeriod;	// sampling time on the timeline
+} MRLOOP;
+
+// loops of the same period, stepped together
+typedef struct tagMrGroup {
+	unsigned long long llPeriod;	// period on the timeline
+	unsigned long long llNext;	// next time the group is due
+	unsigned  uFirst;			// first loop of the group
+	unsigned  uNbr;				// number of loops
+} MRGROUP;
+
+// multi-rate executor of independent loops
+typedef struct tagMrSched {
+	MRLOOP   *Loops;			// sorted by period
+	unsigned  uNbrLoops;
+	MRGROUP  *Groups;			// in rate-monotonic order (fastest first)
+	unsigned  uNbrGroups;
+	unsigned long long llNow;	// current time on the timeline
+	unsigned long long llTick;	// greatest common divisor of the periods
+	unsigned long long llHyper;	// hyperperiod, 0 if it overflows
+	unsigned long long llSteps;	// loop steps taken
+} MRSCHED;
+
+int MrInit (MRSCHED *Sched, const SCENARIO *Cases, unsigned uNbrCases);
+
+void MrRun (MRSCHED *Sched, double lfTime);
+
+void MrFree (MRSCHED *Sched);
+
+int MrSession (const char *cFileName);
+
+#endif // __MULTIRATE_H__
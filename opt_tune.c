@@ -0,0 +1,647 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "opt_tune.h"
+#include "tune_batch.h"
+#include "worker.h"
+#include "util_func.h"
+
+#define OPT_STEP    0.5   // initial simplex edge and CMA-ES step size (log gains)
+
+// data shared by the evaluation jobs
+typedef struct tagOptCtx {
+	const OPTPROBLEM *Prob;
+	OPTPOINT         *Points;
+} OPTCTX;
+
+
+/**
+*  -------------------------------------------------------  *
+*  OPTEVALUATE() runs the closed loop of one candidate and
+*  scores its set-point response:
+*
+*     J = IAE + wOS OS + wU TV(u) + wSat Tsat
+*
+*  where TV(u) is the total variation of the plant input
+*  and Tsat the time spent at UMIN or UMAX. The log gains
+*  are clipped to [OPT_LOGMIN OPT_LOGMAX] first.
+*
+*  Inputs:
+*     *Prob : tuning problem
+*     *Point: candidate, with its log gains lfX
+*
+*  Outputs:
+*     *Point: gains, response and cost of the candidate
+*  -------------------------------------------------------  *
+*/
+void OptEvaluate (const OPTPROBLEM *Prob, OPTPOINT *Point)
+{
+	const SIMSET *SimSet = Prob->SimSet;
+
+	const OPTCOST *Cost = &Prob->Cost;
+
+	CASESET Case;
+
+	LOOP Loop;
+
+	short sUOld = 0;
+
+	unsigned i;
+
+	for (i = 0; i < OPT_DIM; i++)
+		Point->lfX[i] = sat(Point->lfX[i], OPT_LOGMIN, OPT_LOGMAX);
+
+	Case          = Prob->Case;
+	Case.sSimCase = MANUAL;
+	Case.PID.K    = exp(Point->lfX[0]);
+	Case.PID.Ti   = exp(Point->lfX[1]);
+	Case.PID.Td   = exp(Point->lfX[2]);
+
+	Point->PID      = Case.PID;
+	Point->fEffort  = 0;
+	Point->fSatTime = 0;
+
+	LoopInit(&Loop, &Case);
+	MetricsInit(&Point->Metrics, (float)Case.sSetpoint / PREC);
+
+	for (i = 0; i < SimSet->uNbrIter; i++)
+	{
+		LoopStep(&Loop, SimSet);
+		MetricsUpdate(&Point->Metrics, i * SimSet->fTs, (float)Loop.sSysOut / PREC, SimSet->fTs);
+
+		Point->fEffort += (float)abs(Loop.sSysIn - sUOld) / PREC;
+		sUOld           = Loop.sSysIn;
+
+		if (Loop.sSysIn >= UMAX * PREC || Loop.sSysIn <= UMIN * PREC)
+			Point->fSatTime += SimSet->fTs;
+	}
+
+	MetricsFinish(&Point->Metrics, SimSet->fTs);
+
+	Point->lfCost = Point->Metrics.fIAE + Cost->fWOvershoot * Point->Metrics.fOvershoot
+	              + Cost->fWEffort * Point->fEffort + Cost->fWSat * Point->fSatTime;
+
+	if (!isfinite(Point->lfCost))
+		Point->lfCost = OPT_HUGE;
+
+} // End: OptEvaluate()
+
+
+/**
+*  -------------------------------------------------------  *
+*  OPTJOB() evaluates one candidate of a batch.
+*  -------------------------------------------------------  *
+*/
+static void OptJob (void *pCtx, unsigned uPoint)
+{
+	OPTCTX *Ctx = pCtx;
+
+	OptEvaluate(Ctx->Prob, &Ctx->Points[uPoint]);
+
+} // End: OptJob()
+
+
+/**
+*  -------------------------------------------------------  *
+*  OPTBATCH() evaluates a batch of candidates on a pool of
+*  threads and keeps the best one seen in the result.
+*  -------------------------------------------------------  *
+*/
+static void OptBatch (
+		   const OPTPROBLEM *Prob,
+		   OPTPOINT *Points,
+		   unsigned uNbrPoints,
+		   unsigned uNbrThreads,
+		   OPTRESULT *Result
+		   )
+{
+	OPTCTX Ctx;
+
+	unsigned i;
+
+	Ctx.Prob   = Prob;
+	Ctx.Points = Points;
+
+	WorkerRun(uNbrThreads, uNbrPoints, OptJob, &Ctx);
+
+	for (i = 0; i < uNbrPoints; i++)
+	{
+		if (Result->uNbrEval == 0 || Points[i].lfCost < Result->Best.lfCost)
+			Result->Best = Points[i];
+
+		Result->uNbrEval++;
+	}
+
+} // End: OptBatch()
+
+
+/**
+*  -------------------------------------------------------  *
+*  COMPARECOST() orders candidates by increasing cost.
+*  -------------------------------------------------------  *
+*/
+static int CompareCost (const void *pA, const void *pB)
+{
+	const OPTPOINT *A = pA, *B = pB;
+
+	if (A->lfCost < B->lfCost)
+		return -1;
+
+	return A->lfCost > B->lfCost;
+} // End: CompareCost()
+
+
+/**
+*  -------------------------------------------------------  *
+*  NELDERMEADSEARCH() is the downhill simplex method. The
+*  reflection, expansion and both contractions of an ite-
+*  ration are evaluated together in parallel, and so are
+*  the vertices of a shrink. The quantized plant output
+*  makes the cost flat in places, so a collapsed simplex
+*  is restarted around the best point as long as that
+*  improves it.
+*  -------------------------------------------------------  *
+*/
+static void NelderMeadSearch (
+		   const OPTPROBLEM *Prob,
+		   const double *lfX0,
+		   unsigned uMaxEval,
+		   unsigned uNbrThreads,
+		   OPTRESULT *Result
+		   )
+{
+	OPTPOINT Simplex[OPT_DIM + 1];
+
+	OPTPOINT Trial[4];	// reflection, expansion, outside and inside contraction
+
+	const double lfCoef[4] = {1, 2, 0.5, -0.5};
+
+	double lfCentroid[OPT_DIM], lfSize, lfRestart = OPT_HUGE;
+
+	unsigned i, j, k;
+
+	for (i = 0; i <= OPT_DIM; i++)
+	{
+		memcpy(Simplex[i].lfX, lfX0, sizeof(Simplex[i].lfX));
+
+		if (i > 0)
+			Simplex[i].lfX[i - 1] += OPT_STEP;
+	}
+
+	OptBatch(Prob, Simplex, OPT_DIM + 1, uNbrThreads, Result);
+
+	while (Result->uNbrEval + OPT_DIM + 4 <= uMaxEval)
+	{
+		qsort(Simplex, OPT_DIM + 1, sizeof(OPTPOINT), CompareCost);
+
+		/* converged when every vertex is close to the best */
+		lfSize = 0;
+		for (i = 1; i <= OPT_DIM; i++)
+			for (j = 0; j < OPT_DIM; j++)
+				lfSize = max(lfSize, fabs(Simplex[i].lfX[j] - Simplex[0].lfX[j]));
+
+		if (lfSize < OPT_TOL)
+		{
+			if (Simplex[0].lfCost >= lfRestart)
+				break;
+
+			lfRestart = Simplex[0].lfCost;
+
+			for (i = 1; i <= OPT_DIM; i++)
+			{
+				memcpy(Simplex[i].lfX, Simplex[0].lfX, sizeof(Simplex[i].lfX));
+				Simplex[i].lfX[i - 1] += OPT_STEP;
+			}
+
+			OptBatch(Prob, &Simplex[1], OPT_DIM, uNbrThreads, Result);
+			continue;
+		}
+
+		for (j = 0; j < OPT_DIM; j++)
+		{
+			lfCentroid[j] = 0;
+			for (i = 0; i < OPT_DIM; i++)
+				lfCentroid[j] += Simplex[i].lfX[j] / OPT_DIM;
+		}
+
+		for (k = 0; k < 4; k++)
+			for (j = 0; j < OPT_DIM; j++)
+				Trial[k].lfX[j] = lfCentroid[j] + lfCoef[k] * (lfCentroid[j] - Simplex[OPT_DIM].lfX[j]);
+
+		OptBatch(Prob, Trial, 4, uNbrThreads, Result);
+		Result->uNbrIter++;
+
+		if (Trial[0].lfCost < Simplex[0].lfCost)
+			Simplex[OPT_DIM] = (Trial[1].lfCost < Trial[0].lfCost) ? Trial[1] : Trial[0];
+		else if (Trial[0].lfCost < Simplex[OPT_DIM - 1].lfCost)
+			Simplex[OPT_DIM] = Trial[0];
+		else if (Trial[0].lfCost < Simplex[OPT_DIM].lfCost && Trial[2].lfCost <= Trial[0].lfCost)
+			Simplex[OPT_DIM] = Trial[2];
+		else if (Trial[0].lfCost >= Simplex[OPT_DIM].lfCost && Trial[3].lfCost < Simplex[OPT_DIM].lfCost)
+			Simplex[OPT_DIM] = Trial[3];
+		else
+		{
+			/* shrink towards the best vertex */
+			for (i = 1; i <= OPT_DIM; i++)
+				for (j = 0; j < OPT_DIM; j++)
+					Simplex[i].lfX[j] = 0.5 * (Simplex[0].lfX[j] + Simplex[i].lfX[j]);
+
+			OptBatch(Prob, &Simplex[1], OPT_DIM, uNbrThreads, Result);
+		}
+	}
+
+} // End: NelderMeadSearch()
+
+
+/**
+*  -------------------------------------------------------  *
+*  RANDGAUSS() returns a standard normal sample (xorshift*
+*  generator and Box-Muller transform).
+*  -------------------------------------------------------  *
+*/
+static double RandGauss (unsigned long long *llState)
+{
+	double lfU[2];
+
+	unsigned i;
+
+	for (i = 0; i < 2; i++)
+	{
+		*llState ^= *llState >> 12;
+		*llState ^= *llState << 25;
+		*llState ^= *llState >> 27;
+
+		lfU[i] = ((*llState * 2685821657736338717ULL) >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+	return sqrt(-2 * log(max(lfU[0], 1e-300))) * cos(2 * pi * lfU[1]);
+} // End: RandGauss()
+
+
+/**
+*  -------------------------------------------------------  *
+*  EIGENSYM() decomposes a symmetric matrix C = B diag(E)
+*  B' with cyclic Jacobi rotations.
+*  -------------------------------------------------------  *
+*/
+static void EigenSym (double C[OPT_DIM][OPT_DIM], double B[OPT_DIM][OPT_DIM], double *lfE)
+{
+	double A[OPT_DIM][OPT_DIM], lfOff, lfTheta, t, c, s, x, y;
+
+	unsigned i, p, q, k;
+
+	memcpy(A, C, sizeof(A));
+
+	for (p = 0; p < OPT_DIM; p++)
+		for (q = 0; q < OPT_DIM; q++)
+			B[p][q] = (p == q);
+
+	for (i = 0; i < 50; i++)
+	{
+		lfOff = 0;
+		for (p = 0; p < OPT_DIM; p++)
+			for (q = p + 1; q < OPT_DIM; q++)
+				lfOff += A[p][q] * A[p][q];
+
+		if (lfOff < 1e-30)
+			break;
+
+		for (p = 0; p < OPT_DIM; p++)
+		{
+			for (q = p + 1; q < OPT_DIM; q++)
+			{
+				if (A[p][q] == 0)
+					continue;
+
+				lfTheta = (A[q][q] - A[p][p]) / (2 * A[p][q]);
+				t = ((lfTheta >= 0) ? 1 : -1) / (fabs(lfTheta) + sqrt(lfTheta * lfTheta + 1));
+				c = 1 / sqrt(t * t + 1);
+				s = t * c;
+
+				for (k = 0; k < OPT_DIM; k++)
+				{
+					x = A[k][p]; y = A[k][q];
+					A[k][p] = c * x - s * y;
+					A[k][q] = s * x + c * y;
+				}
+				for (k = 0; k < OPT_DIM; k++)
+				{
+					x = A[p][k]; y = A[q][k];
+					A[p][k] = c * x - s * y;
+					A[q][k] = s * x + c * y;
+				}
+				for (k = 0; k < OPT_DIM; k++)
+				{
+					x = B[k][p]; y = B[k][q];
+					B[k][p] = c * x - s * y;
+					B[k][q] = s * x + c * y;
+				}
+			}
+		}
+	}
+
+	for (p = 0; p < OPT_DIM; p++)
+		lfE[p] = max(A[p][p], 1e-20);
+
+} // End: EigenSym()
+
+
+/**
+*  -------------------------------------------------------  *
+*  CMAESSEARCH() is the (mu/mu_w, lambda) CMA-ES with cu-
+*  mulative step-size adaptation and rank-one plus rank-mu
+*  covariance updates. The OPT_LAMBDA candidates of a ge-
+*  neration are evaluated in parallel.
+*  -------------------------------------------------------  *
+*/
+static void CmaesSearch (
+		   const OPTPROBLEM *Prob,
+		   const double *lfX0,
+		   unsigned uMaxEval,
+		   unsigned uNbrThreads,
+		   OPTRESULT *Result
+		   )
+{
+	enum { n = OPT_DIM, MU = OPT_LAMBDA / 2 };
+
+	OPTPOINT Pop[OPT_LAMBDA];
+
+	double lfM[n], lfMOld[n], lfPs[n], lfPc[n], lfYw[n], lfZ[n], lfBz[n];
+
+	double C[n][n], B[n][n], lfD[n], lfW[MU], lfY[MU][n];
+
+	double lfSigma = OPT_STEP, lfMuEff, lfCs, lfDs, lfCc, lfC1, lfCmu, lfChiN, lfNorm, lfSum;
+
+	unsigned long long llState = OPT_SEED;
+
+	unsigned i, j, k, uGen = 0;
+
+	int bHs;
+
+	/* strategy parameters */
+	for (i = 0, lfSum = 0; i < MU; i++)
+	{
+		lfW[i] = log(MU + 0.5) - log(i + 1);
+		lfSum += lfW[i];
+	}
+	for (i = 0, lfMuEff = 0; i < MU; i++)
+	{
+		lfW[i]  /= lfSum;
+		lfMuEff += lfW[i] * lfW[i];
+	}
+	lfMuEff = 1 / lfMuEff;
+
+	lfCs   = (lfMuEff + 2) / (n + lfMuEff + 5);
+	lfDs   = 1 + 2 * max(0, sqrt((lfMuEff - 1) / (n + 1)) - 1) + lfCs;
+	lfCc   = (4 + lfMuEff / n) / (n + 4 + 2 * lfMuEff / n);
+	lfC1   = 2 / ((n + 1.3) * (n + 1.3) + lfMuEff);
+	lfCmu  = min(1 - lfC1, 2 * (lfMuEff - 2 + 1 / lfMuEff) / ((n + 2) * (n + 2) + lfMuEff));
+	lfChiN = sqrt(n) * (1 - 1.0 / (4 * n) + 1.0 / (21 * n * n));
+
+	memcpy(lfM, lfX0, sizeof(lfM));
+
+	for (i = 0; i < n; i++)
+	{
+		lfPs[i] = lfPc[i] = 0;
+		lfD[i]  = 1;
+
+		for (j = 0; j < n; j++)
+			C[i][j] = B[i][j] = (i == j);
+	}
+
+	while (Result->uNbrEval + OPT_LAMBDA <= uMaxEval)
+	{
+		/* sample: x = m + sigma B D z */
+		for (k = 0; k < OPT_LAMBDA; k++)
+		{
+			for (i = 0; i < n; i++)
+				lfZ[i] = lfD[i] * RandGauss(&llState);
+
+			for (i = 0; i < n; i++)
+			{
+				Pop[k].lfX[i] = lfM[i];
+				for (j = 0; j < n; j++)
+					Pop[k].lfX[i] += lfSigma * B[i][j] * lfZ[j];
+			}
+		}
+
+		OptBatch(Prob, Pop, OPT_LAMBDA, uNbrThreads, Result);
+		Result->uNbrIter = ++uGen;
+
+		qsort(Pop, OPT_LAMBDA, sizeof(OPTPOINT), CompareCost);
+
+		/* recombination, from the clipped points */
+		memcpy(lfMOld, lfM, sizeof(lfM));
+
+		for (i = 0; i < n; i++)
+		{
+			lfM[i] = 0;
+			for (k = 0; k < MU; k++)
+				lfM[i] += lfW[k] * Pop[k].lfX[i];
+
+			lfYw[i] = (lfM[i] - lfMOld[i]) / lfSigma;
+
+			for (k = 0; k < MU; k++)
+				lfY[k][i] = (Pop[k].lfX[i] - lfMOld[i]) / lfSigma;
+		}
+
+		/* step-size path, with C^-1/2 = B D^-1 B' */
+		for (j = 0; j < n; j++)
+		{
+			lfZ[j] = 0;
+			for (i = 0; i < n; i++)
+				lfZ[j] += B[i][j] * lfYw[i];
+			lfZ[j] /= lfD[j];
+		}
+
+		for (i = 0, lfNorm = 0; i < n; i++)
+		{
+			lfBz[i] = 0;
+			for (j = 0; j < n; j++)
+				lfBz[i] += B[i][j] * lfZ[j];
+
+			lfPs[i] = (1 - lfCs) * lfPs[i] + sqrt(lfCs * (2 - lfCs) * lfMuEff) * lfBz[i];
+			lfNorm += lfPs[i] * lfPs[i];
+		}
+		lfNorm = sqrt(lfNorm);
+
+		bHs = lfNorm / sqrt(1 - pow(1 - lfCs, 2 * uGen)) < (1.4 + 2.0 / (n + 1)) * lfChiN;
+
+		/* covariance path and update */
+		for (i = 0; i < n; i++)
+			lfPc[i] = (1 - lfCc) * lfPc[i] + bHs * sqrt(lfCc * (2 - lfCc) * lfMuEff) * lfYw[i];
+
+		for (i = 0; i < n; i++)
+		{
+			for (j = 0; j < n; j++)
+			{
+				lfSum = 0;
+				for (k = 0; k < MU; k++)
+					lfSum += lfW[k] * lfY[k][i] * lfY[k][j];
+
+				C[i][j] = (1 - lfC1 - lfCmu) * C[i][j] + lfCmu * lfSum
+				        + lfC1 * (lfPc[i] * lfPc[j] + (1 - bHs) * lfCc * (2 - lfCc) * C[i][j]);
+			}
+		}
+
+		lfSigma *= exp(lfCs / lfDs * (lfNorm / lfChiN - 1));
+
+		EigenSym(C, B, lfD);
+
+		for (i = 0, lfNorm = 0; i < n; i++)
+		{
+			lfD[i] = sqrt(lfD[i]);
+			lfNorm = max(lfNorm, lfD[i]);
+		}
+
+		if (lfSigma * lfNorm < OPT_TOL)
+			break;
+	}
+
+} // End: CmaesSearch()
+
+
+/**
+*  -------------------------------------------------------  *
+*  OPTTUNE() searches the PID gains that minimize the cost
+*  of OptEvaluate() over log(K), log(Ti) and log(Td), the
+*  filter factor N being kept from the start point. Every
+*  batch of candidates is evaluated on a pool of threads.
+*
+*  Inputs:
+*     *Prob      : tuning problem
+*     sMethod    : NELDERMEAD or CMAES
+*     *Start     : start point, e.g. relay Z-N gains
+*     uMaxEval   : evaluation budget
+*     uNbrThreads: number of threads (0 uses all processors)
+*
+*  Outputs:
+*     *Result: best candidate and search counters
+*  -------------------------------------------------------  *
+*/
+void OptTune (
+		   const OPTPROBLEM *Prob,
+		   short sMethod,
+		   const PIDSET *Start,
+		   unsigned uMaxEval,
+		   unsigned uNbrThreads,
+		   OPTRESULT *Result
+		   )
+{
+	OPTPROBLEM Search = *Prob;
+
+	double lfX0[OPT_DIM];
+
+	lfX0[0] = log(max(Start->K , eps));
+	lfX0[1] = log(max(Start->Ti, eps));
+	lfX0[2] = log(max(Start->Td, eps));
+
+	Search.Case.PID.N = Start->N;
+
+	Result->uNbrEval = 0;
+	Result->uNbrIter = 0;
+
+	if (sMethod == CMAES)
+		CmaesSearch(&Search, lfX0, uMaxEval, uNbrThreads, Result);
+	else
+		NelderMeadSearch(&Search, lfX0, uMaxEval, uNbrThreads, Result);
+
+} // End: OptTune()
+
+
+/**
+*  -------------------------------------------------------  *
+*  PRINTPOINT() prints one line of the tuning report.
+*  -------------------------------------------------------  *
+*/
+static void PrintPoint (const char *cName, const OPTPOINT *Point)
+{
+	printf("%-10s %8.3f %8.3f %8.3f | %8.3f %8.2f %8.2f %8.2f %10.3f\n", cName,
+	       Point->PID.K, Point->PID.Ti, Point->PID.Td, Point->Metrics.fIAE, Point->Metrics.fOvershoot,
+	       Point->fEffort, Point->fSatTime, Point->lfCost);
+
+} // End: PrintPoint()
+
+
+/**
+*  -------------------------------------------------------  *
+*  OPTTUNESESSION() asks user for a set-point, a search
+*  method and the cost weights, starts the search from the
+*  relay Z-N gains and compares both sets of gains.
+*
+*  Inputs:
+*     *SimSet: structure of the simulation settings
+*  -------------------------------------------------------  *
+*/
+void OptTuneSession (const SIMSET *SimSet)
+{
+	OPTPROBLEM Prob;
+
+	OPTRESULT Result;
+
+	OPTPOINT Start;
+
+	SCENARIO Plant;
+
+	TUNERESULT Relay;
+
+	unsigned uNbrThreads;
+
+	int iMethod;
+
+	double lfStart, lfElapsed;
+
+	Prob.SimSet          = SimSet;
+	Prob.Case.sSimCase   = MANUAL;
+	Prob.Case.sSetpoint  = GetSetpoint();
+	Prob.Case.fStepAmp   = 0;
+	Prob.Case.fStepDelay = 0;
+	Prob.Case.Plant      = NULL;
+
+	printf("Select the search method:\n   1. Nelder-Mead simplex\n   2. CMA-ES\n");
+	scanf("%i", &iMethod);
+	fflush(stdin);
+
+	printf("Enter cost weights as: overshoot[1/%%] effort saturation[1/sec]\n");
+	scanf("%f %f %f", &Prob.Cost.fWOvershoot, &Prob.Cost.fWEffort, &Prob.Cost.fWSat);
+	fflush(stdin);
+
+	/* relay experiment on the same plant for the start point */
+	memset(&Plant, 0, sizeof(Plant));
+	Plant.Case  = Prob.Case;
+	Plant.fTs   = SimSet->fTs;
+	Plant.fTsim = SimSet->fTs * SimSet->uNbrIter;
+
+	TuneBatch(&Plant, 1, &Relay, 1);
+
+	if (Relay.iStatus != 0)
+	{
+		puts("No sustained relay oscillation, the search starts from the tuned PID.\n");
+		TunedPID(&Relay.PID);
+	}
+
+	Prob.Case.PID = Relay.PID;
+
+	Start.lfX[0] = log(max(Relay.PID.K , eps));
+	Start.lfX[1] = log(max(Relay.PID.Ti, eps));
+	Start.lfX[2] = log(max(Relay.PID.Td, eps));
+	OptEvaluate(&Prob, &Start);
+
+	uNbrThreads = WorkerCount();
+
+	lfStart = WallClock();
+	OptTune(&Prob, (iMethod == 2) ? CMAES : NELDERMEAD, &Relay.PID, OPT_MAXEVAL, uNbrThreads, &Result);
+	lfElapsed = WallClock() - lfStart;
+
+	printf("%u candidates in %u %s scored in %.3f sec on %u threads\n\n", Result.uNbrEval, Result.uNbrIter,
+	       (iMethod == 2) ? "generations" : "iterations", lfElapsed, uNbrThreads);
+
+	printf("%-10s %8s %8s %8s | %8s %8s %8s %8s %10s\n",
+	       "gains", "K", "Ti", "Td", "IAE", "OS [%]", "effort", "Tsat [s]", "cost");
+
+	PrintPoint((Relay.iStatus == 0) ? "relay Z-N" : "tuned", &Start);
+	PrintPoint("optimized", &Result.Best);
+
+} // End: OptTuneSession()
@@ -0,0 +1,66 @@
+#ifndef __OPT_TUNE_H__
+#define __OPT_TUNE_H__
+
+#include "simulation.h"
+#include "metrics.h"
+
+#define OPT_DIM        3      // searched gains: log K, log Ti, log Td
+#define OPT_LAMBDA     12     // CMA-ES candidates per generation
+#define OPT_MAXEVAL    2000   // default evaluation budget
+#define OPT_LOGMIN    -7.0    // bounds of the searched log gains
+#define OPT_LOGMAX     7.0
+#define OPT_TOL        1e-4   // convergence of the log gains
+#define OPT_SEED       12345  // CMA-ES random seed (repeatable runs)
+#define OPT_HUGE       1e30   // cost of a failed candidate
+
+enum OptMethod
+{
+	NELDERMEAD,	// 0
+	CMAES			// 1
+};
+
+// weights of the closed-loop cost, IAE has weight 1
+typedef struct tagOptCost {
+	float fWOvershoot;	// per percent of overshoot
+	float fWEffort;		// per unit of input total variation
+	float fWSat;			// per second spent at UMIN or UMAX
+} OPTCOST;
+
+// tuning problem: one set-point response
+typedef struct tagOptProblem {
+	const SIMSET *SimSet;	// horizon and sampling time
+	CASESET  Case;			// set-point and plant (only PID.N is used)
+	OPTCOST  Cost;			// cost weights
+} OPTPROBLEM;
+
+// scored candidate
+typedef struct tagOptPoint {
+	double  lfX[OPT_DIM];	// log gains
+	double  lfCost;			// weighted cost
+	PIDSET  PID;				// gains
+	METRICS Metrics;			// set-point response
+	float   fEffort;			// total variation of the input
+	float   fSatTime;			// time at the input limits [sec]
+} OPTPOINT;
+
+// outcome of a search
+typedef struct tagOptResult {
+	OPTPOINT Best;		// best candidate seen
+	unsigned uNbrEval;	// candidates evaluated
+	unsigned uNbrIter;	// iterations or generations
+} OPTRESULT;
+
+void OptEvaluate (const OPTPROBLEM *Prob, OPTPOINT *Point);
+
+void OptTune (
+		   const OPTPROBLEM *Prob,
+		   short sMethod,
+		   const PIDSET *Start,
+		   unsigned uMaxEval,
+		   unsigned uNbrThreads,
+		   OPTRESULT *Result
+		   );
+
+void OptTuneSession (const SIMSET *SimSet);
+
+#endif // __OPT_TUNE_H__
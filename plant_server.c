@@ -0,0 +1,427 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef WIN32
+#include <unistd.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#endif // #ifndef WIN32
+
+#include "plant_server.h"
+#include "util_func.h"
+
+#ifndef WIN32
+
+#define PS_SPIN    1000   // polls of the mailbox before yielding the processor
+#define PS_LINE    64     // cache line size
+
+/* one exchange slot per direction, each on its own cache line so
+   the two processes never write to the same line */
+typedef struct tagMailbox {
+	unsigned      uReq;		// number of the last request (controller)
+	short         sU;		// plant input
+	unsigned char bStop;	// the server has to quit
+	char          cPad[PS_LINE - sizeof(unsigned) - sizeof(short) - 1];
+	unsigned      uResp;	// number of the last answer (server)
+	short         sY;		// plant output
+} MAILBOX;
+
+// plant memory of the server process
+typedef struct tagServerPlant {
+	const LTIDISC *Disc;		// NULL uses Sys2ndOrder()
+	PLANTSTATE     Plant;
+	LTISTATE       Lti;
+} SERVERPLANT;
+
+
+/**
+*  -------------------------------------------------------  *
+*  SERVERSTEP() advances the plant of the server process.
+*  -------------------------------------------------------  *
+*/
+static short ServerStep (SERVERPLANT *Server, short sU)
+{
+	if (Server->Disc != NULL)
+		return LtiStep(&Server->Lti, Server->Disc, sU);
+
+	return Sys2ndOrder(&Server->Plant, sU);
+} // End: ServerStep()
+
+
+/**
+*  -------------------------------------------------------  *
+*  MAILBOXWAIT() polls a sequence number of the mailbox
+*  until it reaches uSeq. The processor is yielded every
+*  PS_SPIN polls; the wait also ends there if the other
+*  process is gone.
+*
+*  Inputs:
+*     *pSeq  : sequence number written by the other side
+*     uSeq   : value to wait for
+*     iParent: controller process (0: do not check)
+*     iChild : server process (0: do not check)
+*
+*  Outputs:
+*     0 when uSeq is reached, -1 if the other process is
+*     gone
+*  -------------------------------------------------------  *
+*/
+static int MailboxWait (unsigned *pSeq, unsigned uSeq, int iParent, int iChild)
+{
+	unsigned i = 0;
+
+	while (__atomic_load_n(pSeq, __ATOMIC_ACQUIRE) != uSeq)
+	{
+		if (++i % PS_SPIN == 0)
+		{
+			if (iParent != 0 && getppid() != iParent)
+				return -1;
+
+			/* the server has exited (reaped here) or was reaped before */
+			if (iChild != 0 && waitpid(iChild, NULL, WNOHANG) != 0)
+				return -1;
+
+			sched_yield();
+		}
+	}
+
+	return 0;
+} // End: MailboxWait()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SOCKIO() sends or receives one sample over the socket.
+*  -------------------------------------------------------  *
+*/
+static int SockIO (int iSocket, short *sValue, unsigned char bSend)
+{
+	char *pData = (char *)sValue;
+
+	size_t uDone = 0;
+
+	ssize_t iLen;
+
+	while (uDone < sizeof(short))
+	{
+		if (bSend)
+			iLen = write(iSocket, pData + uDone, sizeof(short) - uDone);
+		else
+			iLen = read(iSocket, pData + uDone, sizeof(short) - uDone);
+
+		if (iLen <= 0)
+			return -1;
+
+		uDone += iLen;
+	}
+
+	return 0;
+} // End: SockIO()
+
+
+/**
+*  -------------------------------------------------------  *
+*  PLANTSERVE() is the loop of the server process: it an-
+*  swers every plant input with the next plant output un-
+*  til it is stopped.
+*  -------------------------------------------------------  *
+*/
+static void PlantServe (PLANTLINK *Link, SERVERPLANT *Server, int iParent)
+{
+	MAILBOX *Box = Link->pMailbox;
+
+	unsigned uSeq;
+
+	short sU, sY;
+
+	if (Link->sMode == PS_SOCKET)
+	{
+		while (SockIO(Link->iSocket, &sU, FALSE) == 0)
+		{
+			sY = ServerStep(Server, sU);
+
+			if (SockIO(Link->iSocket, &sY, TRUE) != 0)
+				break;
+		}
+
+		return;
+	}
+
+	for (uSeq = 1; ; uSeq++)
+	{
+		if (MailboxWait(&Box->uReq, uSeq, iParent, 0) != 0 || Box->bStop)
+			break;
+
+		Box->sY = ServerStep(Server, Box->sU);
+
+		__atomic_store_n(&Box->uResp, uSeq, __ATOMIC_RELEASE);
+	}
+
+} // End: PlantServe()
+
+#endif // #ifndef WIN32
+
+
+/**
+*  -------------------------------------------------------  *
+*  PLANTSERVERSTART() starts a process that runs the plant
+*  and answers the plant inputs of PlantExchange(). If the
+*  shared memory is not available, the socket is used.
+*
+*  Inputs:
+*     sMode : PS_SHM or PS_SOCKET
+*     *Plant: discretized plant (NULL uses Sys2ndOrder())
+*
+*  Outputs:
+*     *Link: controller end of the link
+*     0 on success, -1 on failure
+*  -------------------------------------------------------  *
+*/
+int PlantServerStart (PLANTLINK *Link, short sMode, const LTIDISC *Plant)
+{
+#ifdef WIN32
+	puts("Error: the plant server needs a POSIX system!\n");
+	return -1;
+#else
+	SERVERPLANT Server;
+
+	int iSockets[2] = {-1, -1}, iParent;
+
+	Link->sMode    = sMode;
+	Link->pMailbox = NULL;
+	Link->iSocket  = -1;
+	Link->uSeq     = 0;
+	Link->bLost    = FALSE;
+	HistInit(&Link->Rtt);
+
+	if (sMode == PS_SHM)
+	{
+		Link->pMailbox = mmap(NULL, sizeof(MAILBOX), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+		if (Link->pMailbox == MAP_FAILED)
+		{
+			puts("Shared memory is not available, the plant server uses a socket.");
+			Link->pMailbox = NULL;
+			Link->sMode    = PS_SOCKET;
+		}
+	}
+
+	if (Link->sMode == PS_SOCKET && socketpair(AF_UNIX, SOCK_STREAM, 0, iSockets) != 0)
+	{
+		perror("Error opening socket");
+		return -1;
+	}
+
+	Server.Disc  = Plant;
+	Server.Plant = PlantInit();
+	Server.Lti   = LtiInit();
+
+	iParent = getpid();
+
+	fflush(stdout);
+	Link->iPid = fork();
+
+	if (Link->iPid < 0)
+	{
+		perror("Error starting the plant server");
+		if (iSockets[1] >= 0)
+			close(iSockets[1]);
+		Link->iSocket = iSockets[0];
+		PlantServerStop(Link);
+		return -1;
+	}
+
+	if (Link->iPid == 0)
+	{
+		/* server process */
+		Link->iSocket = iSockets[1];
+		if (iSockets[0] >= 0)
+			close(iSockets[0]);
+
+		PlantServe(Link, &Server, iParent);
+		_exit(0);
+	}
+
+	Link->iSocket = iSockets[0];
+	if (iSockets[1] >= 0)
+		close(iSockets[1]);
+
+	return 0;
+#endif // #ifdef WIN32
+} // End: PlantServerStart()
+
+
+/**
+*  -------------------------------------------------------  *
+*  PLANTEXCHANGE() sends the plant input to the server
+*  and waits for the plant output. The round-trip time is
+*  recorded in Link->Rtt. If the server process is gone,
+*  Link->bLost is set and no more exchanges take place.
+*
+*  Inputs:
+*     *Link: link to the plant server
+*     sU   : plant input
+*
+*  Outputs:
+*     sY: plant output (0 if the server is lost)
+*  -------------------------------------------------------  *
+*/
+short PlantExchange (PLANTLINK *Link, short sU)
+{
+#ifdef WIN32
+	return 0;
+#else
+	MAILBOX *Box = Link->pMailbox;
+
+	double lfStart;
+
+	short sY = 0;
+
+	if (Link->bLost)
+		return 0;
+
+	lfStart = WallClock();
+
+	if (Link->sMode == PS_SHM)
+	{
+		Box->sU = sU;
+		__atomic_store_n(&Box->uReq, ++Link->uSeq, __ATOMIC_RELEASE);
+
+		if (MailboxWait(&Box->uResp, Link->uSeq, 0, Link->iPid) == 0)
+			sY = Box->sY;
+		else
+			Link->bLost = TRUE;
+	}
+	else if (SockIO(Link->iSocket, &sU, TRUE) != 0 || SockIO(Link->iSocket, &sY, FALSE) != 0)
+	{
+		Link->bLost = TRUE;
+		sY = 0;
+	}
+
+	if (Link->bLost)
+	{
+		puts("Error: the plant server does not answer!\n");
+		return 0;
+	}
+
+	HistAdd(&Link->Rtt, (WallClock() - lfStart) * 1e9);
+
+	return sY;
+#endif // #ifdef WIN32
+} // End: PlantExchange()
+
+
+/**
+*  -------------------------------------------------------  *
+*  PLANTSERVERSTOP() stops the plant server process and
+*  releases the link.
+*
+*  Inputs:
+*     *Link: link to the plant server
+*  -------------------------------------------------------  *
+*/
+void PlantServerStop (PLANTLINK *Link)
+{
+#ifndef WIN32
+	MAILBOX *Box = Link->pMailbox;
+
+	if (Box != NULL)
+	{
+		Box->bStop = TRUE;
+		__atomic_store_n(&Box->uReq, ++Link->uSeq, __ATOMIC_RELEASE);
+	}
+
+	if (Link->iSocket >= 0)
+		close(Link->iSocket);
+
+	if (Link->iPid > 0)
+		waitpid(Link->iPid, NULL, 0);
+
+	if (Box != NULL)
+		munmap(Box, sizeof(MAILBOX));
+
+	Link->pMailbox = NULL;
+	Link->iSocket  = -1;
+	Link->iPid     = 0;
+#endif // #ifndef WIN32
+} // End: PlantServerStop()
+
+
+/**
+*  -------------------------------------------------------  *
+*  PLANTSERVERRUN() runs a closed loop with a fixed PID
+*  whose plant (Sys2ndOrder()) is in a plant server pro-
+*  cess. The same loop runs in-process alongside, so the
+*  outputs of the two can be compared. The round-trip ti-
+*  mes of the exchanges and the loop rate are printed.
+*
+*  Inputs:
+*     sMode      : PS_SHM or PS_SOCKET
+*     *PID       : PID gains
+*     fSetpoint  : set-point
+*     uNbrSamples: number of samples
+*
+*  Outputs:
+*     0 if both loops agree, -1 otherwise or if the server
+*     is lost
+*  -------------------------------------------------------  *
+*/
+int PlantServerRun (short sMode, const PIDSET *PID, float fSetpoint, unsigned uNbrSamples)
+{
+	PLANTLINK Link;
+
+	SIMSET SimSet;
+
+	CASESET Case;
+
+	LOOP Loop, Shadow;
+
+	double lfStart, lfElapsed;
+
+	unsigned i, uNbrDiff = 0;
+
+	SimSet.fTs      = SAMPLINGTIME;
+	SimSet.uNbrIter = uNbrSamples;
+
+	Case.sSimCase   = TUNED;
+	Case.sSetpoint  = fSetpoint * PREC;
+	Case.fStepAmp   = 0;
+	Case.fStepDelay = 0;
+	Case.PID        = *PID;
+	Case.Plant      = NULL;
+
+	if (PlantServerStart(&Link, sMode, NULL) != 0)
+		return -1;
+
+	LoopInit(&Loop, &Case);
+	LoopInit(&Shadow, &Case);
+
+	lfStart = WallClock();
+
+	for (i = 0; i < uNbrSamples; i++)
+	{
+		Loop.sSysOut = PlantExchange(&Link, Loop.sSysIn);
+		if (Link.bLost)
+			break;
+
+		LoopControl(&Loop, &SimSet);
+
+		LoopStep(&Shadow, &SimSet);
+
+		if (Loop.sSysOut != Shadow.sSysOut)
+			uNbrDiff++;
+	}
+
+	lfElapsed = WallClock() - lfStart;
+
+	PlantServerStop(&Link);
+
+	HistPrint(&Link.Rtt, (Link.sMode == PS_SHM) ? "shm rtt" : "socket rtt");
+	printf("%u samples at %.0f Hz, %u outputs differ from the in-process loop\n",
+	       i, i / max(lfElapsed, eps), uNbrDiff);
+
+	return (uNbrDiff > 0 || Link.bLost) ? -1 : 0;
+} // End: PlantServerRun()
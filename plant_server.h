@@ -0,0 +1,34 @@
+#ifndef __PLANT_SERVER_H__
+#define __PLANT_SERVER_H__
+
+#include "simulation.h"
+#include "histogram.h"
+
+#define PS_SAMPLES   100000   // samples of a plant server run
+
+enum PlantLinkMode
+{
+	PS_SHM,		// 0: lock-free shared-memory mailbox
+	PS_SOCKET	// 1: UNIX socket pair
+};
+
+// controller end of the link to a plant server process
+typedef struct tagPlantLink {
+	short     sMode;		// PS_SHM or PS_SOCKET
+	int       iPid;			// plant server process
+	void     *pMailbox;	// shared mailbox (PS_SHM)
+	int       iSocket;		// controller end of the socket (PS_SOCKET)
+	unsigned  uSeq;			// number of the last request
+	unsigned char bLost;	// the server process is gone
+	HISTOGRAM Rtt;			// round-trip times of the exchanges [ns]
+} PLANTLINK;
+
+int PlantServerStart (PLANTLINK *Link, short sMode, const LTIDISC *Plant);
+
+short PlantExchange (PLANTLINK *Link, short sU);
+
+void PlantServerStop (PLANTLINK *Link);
+
+int PlantServerRun (short sMode, const PIDSET *PID, float fSetpoint, unsigned uNbrSamples);
+
+#endif // __PLANT_SERVER_H__
@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "rls.h"
+#include "util_func.h"
+
+
+/**
+*  -------------------------------------------------------  *
+*  RLSINIT() starts an estimator with zero parameters and
+*  the covariance RLS_P0 I.
+*
+*  Inputs:
+*     lfLambda: forgetting factor in (0, 1], 1 remembers
+*               every sample
+*
+*  Outputs:
+*     Rls: estimator state
+*  -------------------------------------------------------  *
+*/
+RLSSTATE RlsInit (double lfLambda)
+{
+	RLSSTATE Rls;
+
+	unsigned i;
+
+	memset(&Rls, 0, sizeof(Rls));
+
+	for (i = 0; i < RLS_NBR_PAR; i++)
+	{
+		Rls.lfU[i][i] = 1;
+		Rls.lfD[i]    = RLS_P0;
+	}
+
+	Rls.lfLambda = sat(lfLambda, 0.5, 1);
+
+	return Rls;
+} // End: RlsInit()
+
+
+/**
+*  -------------------------------------------------------  *
+*  RLSUPDATE() takes one sample into the estimate with the
+*  Bierman update of the U D U' factors of the covariance:
+*  O(n^2) work, and P stays symmetric and positive defin-
+*  ite however long the run. The variances are capped at
+*  RLS_P0, so forgetting does not blow them up while the
+*  input is not exciting.
+*
+*  Inputs:
+*     *Rls: estimator state
+*     lfU : plant input, as passed with the call that gave
+*           lfY (it acts on the next outputs)
+*     lfY : plant output
+*  -------------------------------------------------------  *
+*/
+void RlsUpdate (RLSSTATE *Rls, double lfU, double lfY)
+{
+	double f[RLS_NBR_PAR], k[RLS_NBR_PAR], lfAlpha, lfBeta, lfP, lfTmp;
+
+	unsigned i, j;
+
+	/* a priori prediction error */
+	Rls->lfErr = lfY;
+	for (i = 0; i < RLS_NBR_PAR; i++)
+		Rls->lfErr -= Rls->lfTheta[i] * Rls->lfPhi[i];
+
+	/* f = U' phi */
+	for (j = 0; j < RLS_NBR_PAR; j++)
+	{
+		f[j] = Rls->lfPhi[j];
+		for (i = 0; i < j; i++)
+			f[j] += Rls->lfU[i][j] * Rls->lfPhi[i];
+	}
+
+	/* column by column update of U and D, gain K = k / alpha */
+	lfAlpha = Rls->lfLambda;
+
+	for (j = 0; j < RLS_NBR_PAR; j++)
+	{
+		lfBeta  = lfAlpha;
+		k[j]    = Rls->lfD[j] * f[j];
+		lfAlpha = lfBeta + k[j] * f[j];
+		lfP     = -f[j] / lfBeta;
+
+		Rls->lfD[j] *= lfBeta / (lfAlpha * Rls->lfLambda);
+		Rls->lfD[j]  = min(Rls->lfD[j], RLS_P0);
+
+		for (i = 0; i < j; i++)
+		{
+			lfTmp          = Rls->lfU[i][j];
+			Rls->lfU[i][j] = lfTmp + k[i] * lfP;
+			k[i]          += lfTmp * k[j];
+		}
+	}
+
+	for (i = 0; i < RLS_NBR_PAR; i++)
+		Rls->lfTheta[i] += k[i] / lfAlpha * Rls->lfErr;
+
+	/* shift the new sample into the regressor */
+	Rls->lfPhi[2] = Rls->lfPhi[1];
+	Rls->lfPhi[1] = Rls->lfPhi[0];
+	Rls->lfPhi[0] = lfY;
+	Rls->lfPhi[5] = Rls->lfPhi[4];
+	Rls->lfPhi[4] = Rls->lfPhi[3];
+	Rls->lfPhi[3] = lfU;
+
+	Rls->lfSumErr2 += Rls->lfErr * Rls->lfErr;
+	Rls->uNbrUpdates++;
+
+} // End: RlsUpdate()
+
+
+/**
+*  -------------------------------------------------------  *
+*  RLSSTATICGAIN() returns the static gain of the estimat-
+*  ed model, (b1 + b2 + b3) / (1 - a1 - a2 - a3), or 0 if
+*  it has an integrator.
+*  -------------------------------------------------------  *
+*/
+double RlsStaticGain (const RLSSTATE *Rls)
+{
+	double lfDen;
+
+	lfDen = 1 - Rls->lfTheta[0] - Rls->lfTheta[1] - Rls->lfTheta[2];
+
+	if (fabs(lfDen) < eps)
+		return 0;
+
+	return (Rls->lfTheta[3] + Rls->lfTheta[4] + Rls->lfTheta[5]) / lfDen;
+} // End: RlsStaticGain()
+
+
+/**
+*  -------------------------------------------------------  *
+*  RLSREPORT() prints the estimated model next to the true
+*  one.
+*
+*  Inputs:
+*     *Rls   : estimator state
+*     *lfTrue: true {a1, a2, a3, b1, b2, b3}, NULL if unk-
+*              nown
+*  -------------------------------------------------------  *
+*/
+void RlsReport (const RLSSTATE *Rls, const double *lfTrue)
+{
+	double lfDen;
+
+	unsigned i;
+
+	if (Rls->uNbrUpdates == 0)
+		return;
+
+	printf("\nOnline ARX estimate (RLS, lambda %.3f, %u samples, rms prediction error %.3g):\n",
+	       Rls->lfLambda, Rls->uNbrUpdates, sqrt(Rls->lfSumErr2 / Rls->uNbrUpdates));
+	printf("%-9s %9s %9s %9s %9s %9s %9s %9s\n", "", "a1", "a2", "a3", "b1", "b2", "b3", "gain");
+
+	printf("%-9s", "estimate");
+	for (i = 0; i < RLS_NBR_PAR; i++)
+		printf(" %9.4f", Rls->lfTheta[i]);
+	printf(" %9.4f\n", RlsStaticGain(Rls));
+
+	if (lfTrue != NULL)
+	{
+		lfDen = 1 - lfTrue[0] - lfTrue[1] - lfTrue[2];
+
+		printf("%-9s", "true");
+		for (i = 0; i < RLS_NBR_PAR; i++)
+			printf(" %9.4f", lfTrue[i]);
+		printf(" %9.4f\n", (fabs(lfDen) < eps) ? 0 : (lfTrue[3] + lfTrue[4] + lfTrue[5]) / lfDen);
+	}
+
+} // End: RlsReport()
@@ -0,0 +1,30 @@
+#ifndef __RLS_H__
+#define __RLS_H__
+
+#define RLS_NBR_PAR   6       // a1, a2, a3, b1, b2, b3 of Sys2ndOrder()
+#define RLS_LAMBDA    0.995   // forgetting factor, a memory of about 1/(1 - lambda) samples
+#define RLS_P0        1e4     // initial and largest variance of a parameter
+
+/* recursive least squares estimate of the ARX model
+   y(k) = a1 y(k-1) + a2 y(k-2) + a3 y(k-3) + b1 u(k-1) + b2 u(k-2) + b3 u(k-3)
+   with the covariance kept as P = U D U' (Bierman) */
+typedef struct tagRlsState {
+	double   lfTheta[RLS_NBR_PAR];				// estimates {a1, a2, a3, b1, b2, b3}
+	double   lfPhi[RLS_NBR_PAR];				// regressor {y(k-1), y(k-2), y(k-3), u(k-1), u(k-2), u(k-3)}
+	double   lfU[RLS_NBR_PAR][RLS_NBR_PAR];	// unit upper triangular factor of P
+	double   lfD[RLS_NBR_PAR];					// diagonal factor of P
+	double   lfLambda;							// forgetting factor
+	double   lfErr;								// last prediction error
+	double   lfSumErr2;						// sum of squared prediction errors
+	unsigned uNbrUpdates;						// number of samples seen
+} RLSSTATE;
+
+RLSSTATE RlsInit (double lfLambda);
+
+void RlsUpdate (RLSSTATE *Rls, double lfU, double lfY);
+
+double RlsStaticGain (const RLSSTATE *Rls);
+
+void RlsReport (const RLSSTATE *Rls, const double *lfTrue);
+
+#endif // __RLS_H__
@@ -0,0 +1,281 @@
+#ifdef __linux__
+#define _GNU_SOURCE		// sched_setaffinity()
+#endif // #ifdef __linux__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef WIN32
+#include <time.h>
+#include <errno.h>
+#include <sched.h>
+#include <sys/mman.h>
+#endif // #ifndef WIN32
+
+#include "rt_loop.h"
+#include "async_log.h"
+#include "util_func.h"
+
+#ifndef WIN32
+
+/**
+*  -------------------------------------------------------  *
+*  TSADD() advances a time by lfNs nanoseconds.
+*  -------------------------------------------------------  *
+*/
+static void TsAdd (struct timespec *Ts, double lfNs)
+{
+	long long llNs = (long long)Ts->tv_nsec + (long long)lfNs;
+
+	Ts->tv_sec  += llNs / 1000000000LL;
+	Ts->tv_nsec  = llNs % 1000000000LL;
+
+} // End: TsAdd()
+
+
+/**
+*  -------------------------------------------------------  *
+*  TSDIFF() returns A - B in nanoseconds.
+*  -------------------------------------------------------  *
+*/
+static double TsDiff (const struct timespec *A, const struct timespec *B)
+{
+	return (double)(A->tv_sec - B->tv_sec) * 1e9 + (A->tv_nsec - B->tv_nsec);
+} // End: TsDiff()
+
+#endif // #ifndef WIN32
+
+
+/**
+*  -------------------------------------------------------  *
+*  RTPARSESET() reads real-time settings from a text of
+*  the form period[:priority[:cpu]], the period in sec.
+*
+*  Inputs:
+*     cText: settings text
+*
+*  Outputs:
+*     *RtSet: real-time settings
+*     0 on success, -1 on failure
+*  -------------------------------------------------------  *
+*/
+int RtParseSet (const char *cText, RTSET *RtSet)
+{
+	char *cEnd;
+
+	RtSet->lfPeriod  = strtod(cText, &cEnd);
+	RtSet->iPriority = 0;
+	RtSet->iCpu      = -1;
+
+	if (cEnd == cText || RtSet->lfPeriod <= 0)
+		return -1;
+
+	if (*cEnd == ':')
+		RtSet->iPriority = strtol(cEnd + 1, &cEnd, 10);
+
+	if (*cEnd == ':')
+		RtSet->iCpu = strtol(cEnd + 1, &cEnd, 10);
+
+	return (*cEnd == '\0') ? 0 : -1;
+} // End: RtParseSet()
+
+
+/**
+*  -------------------------------------------------------  *
+*  RTSETUP() prepares the calling thread for real-time
+*  execution: pins it to a processor and switches it to
+*  SCHED_FIFO with locked memory, as requested. A setting
+*  that is not permitted (e.g. without privileges) is re-
+*  ported and the run goes on without it.
+*
+*  Inputs:
+*     *RtSet: real-time settings
+*
+*  Outputs:
+*     0 if every setting is applied, -1 otherwise
+*  -------------------------------------------------------  *
+*/
+int RtSetup (const RTSET *RtSet)
+{
+#ifdef WIN32
+	puts("Error: the real-time mode needs a POSIX system!\n");
+	return -1;
+#else
+	struct sched_param Param;
+
+	int iStatus = 0;
+
+	if (RtSet->iCpu >= 0)
+	{
+#ifdef __linux__
+		cpu_set_t Cpus;
+
+		CPU_ZERO(&Cpus);
+		CPU_SET(RtSet->iCpu, &Cpus);
+
+		if (sched_setaffinity(0, sizeof(Cpus), &Cpus) != 0)
+		{
+			perror("Error pinning to the processor");
+			iStatus = -1;
+		}
+#else
+		puts("Error: processor pinning is not supported!\n");
+		iStatus = -1;
+#endif // #ifdef __linux__
+	}
+
+	if (RtSet->iPriority > 0)
+	{
+		/* no page faults in the loop */
+		if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+		{
+			perror("Error locking memory");
+			iStatus = -1;
+		}
+
+		memset(&Param, 0, sizeof(Param));
+		Param.sched_priority = RtSet->iPriority;
+
+		if (sched_setscheduler(0, SCHED_FIFO, &Param) != 0)
+		{
+			perror("Error setting SCHED_FIFO");
+			iStatus = -1;
+		}
+	}
+
+	return iStatus;
+#endif // #ifdef WIN32
+} // End: RtSetup()
+
+
+/**
+*  -------------------------------------------------------  *
+*  RTRUN() runs one simulation case in real time: sample
+*  k starts at the absolute deadline start + k * period
+*  (clock_nanosleep() with TIMER_ABSTIME, so the period
+*  does not drift). A cycle that ends after the next dea-
+*  dline is a miss; the deadlines that already passed are
+*  skipped instead of run back to back. The samples go
+*  to the logger thread, so the disk never delays a cycle.
+*
+*  Inputs:
+*     *RtSet : real-time settings
+*     *SimSet: structure of the simulation settings
+*     *Case  : simulation case
+*     *ALog  : log of {time input output set-point P I D}
+*              (NULL: none)
+*
+*  Outputs:
+*     *Stats: timing of the cycles
+*     0 on success, -1 on failure
+*  -------------------------------------------------------  *
+*/
+int RtRun (const RTSET *RtSet, const SIMSET *SimSet, const CASESET *Case, ASYNCLOG *ALog, RTSTATS *Stats)
+{
+#ifdef WIN32
+	puts("Error: the real-time mode needs a POSIX system!\n");
+	return -1;
+#else
+	struct timespec Deadline, Prev, Wake, Done;
+
+	double lfPeriodNs, lfNominal = 0, lfJitter, lfSample[DATA_NBR_CHAN];
+
+	unsigned i;
+
+	LOOP Loop;
+
+	HistInit(&Stats->Latency);
+	HistInit(&Stats->Jitter);
+	HistInit(&Stats->Exec);
+	HistInit(&Stats->Overrun);
+	Stats->uNbrCycles = 0;
+	Stats->uNbrMissed = 0;
+
+	lfPeriodNs = RtSet->lfPeriod * 1e9;
+
+	LoopInit(&Loop, Case);
+
+	clock_gettime(CLOCK_MONOTONIC, &Deadline);
+	TsAdd(&Deadline, lfPeriodNs);
+	Prev = Deadline;
+
+	for (i = 0; i < SimSet->uNbrIter; i++)
+	{
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &Deadline, NULL) == EINTR)
+			;
+
+		clock_gettime(CLOCK_MONOTONIC, &Wake);
+
+		LoopStep(&Loop, SimSet);
+
+		if (ALog != NULL)
+		{
+			lfSample[0] = i * SimSet->fTs;
+			lfSample[1] = (double)Loop.sSysIn  / PREC;
+			lfSample[2] = (double)Loop.sSysOut / PREC;
+			lfSample[3] = (double)Loop.Case.sSetpoint / PREC;
+			lfSample[4] = Loop.Ctrl.fP;
+			lfSample[5] = Loop.Ctrl.fI;
+			lfSample[6] = Loop.Ctrl.fD;
+
+			AsyncLogPush(ALog, lfSample);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &Done);
+
+		HistAdd(&Stats->Latency, TsDiff(&Wake, &Deadline));
+		HistAdd(&Stats->Exec, TsDiff(&Done, &Wake));
+
+		if (i > 0)
+		{
+			lfJitter = TsDiff(&Wake, &Prev) - lfNominal;
+			HistAdd(&Stats->Jitter, (lfJitter < 0) ? -lfJitter : lfJitter);
+		}
+
+		Prev = Wake;
+
+		/* next deadline, skipping those already passed */
+		TsAdd(&Deadline, lfPeriodNs);
+		lfNominal = lfPeriodNs;
+
+		if (TsDiff(&Done, &Deadline) > 0)
+		{
+			Stats->uNbrMissed++;
+			HistAdd(&Stats->Overrun, TsDiff(&Done, &Deadline));
+
+			while (TsDiff(&Done, &Deadline) > 0)
+			{
+				TsAdd(&Deadline, lfPeriodNs);
+				lfNominal += lfPeriodNs;
+			}
+		}
+
+		Stats->uNbrCycles++;
+	}
+
+	return 0;
+#endif // #ifdef WIN32
+} // End: RtRun()
+
+
+/**
+*  -------------------------------------------------------  *
+*  RTREPORT() prints the timing of a real-time run.
+*
+*  Inputs:
+*     *RtSet: real-time settings of the run
+*     *Stats: timing of the cycles
+*  -------------------------------------------------------  *
+*/
+void RtReport (const RTSET *RtSet, const RTSTATS *Stats)
+{
+	printf("%u cycles of %.1f us, %u deadlines missed (%.3f %%)\n", Stats->uNbrCycles, RtSet->lfPeriod * 1e6,
+	       Stats->uNbrMissed, 100.0 * Stats->uNbrMissed / max(Stats->uNbrCycles, 1));
+
+	HistPrint(&Stats->Latency, "latency");
+	HistPrint(&Stats->Jitter , "jitter" );
+	HistPrint(&Stats->Exec   , "exec"   );
+	HistPrint(&Stats->Overrun, "overrun");
+
+} // End: RtReport()
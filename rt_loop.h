@@ -0,0 +1,36 @@
+#ifndef __RT_LOOP_H__
+#define __RT_LOOP_H__
+
+#include "simulation.h"
+#include "histogram.h"
+
+#define RT_SAMPLES   10000   // samples of a real-time run
+
+// real-time execution settings
+typedef struct tagRtSet {
+	double lfPeriod;	// wall-clock period of one sample [sec]
+	int    iPriority;	// SCHED_FIFO priority (0: normal scheduling)
+	int    iCpu;		// processor to run on (-1: any)
+} RTSET;
+
+// timing of the cycles of a real-time run [ns]
+typedef struct tagRtStats {
+	HISTOGRAM Latency;		// wake-up time after the deadline
+	HISTOGRAM Jitter;		// deviation of the cycle period from lfPeriod
+	HISTOGRAM Exec;			// compute time of a cycle
+	HISTOGRAM Overrun;		// end of a cycle after the next deadline
+	unsigned  uNbrCycles;	// cycles run
+	unsigned  uNbrMissed;	// cycles that ended after the next deadline
+} RTSTATS;
+
+int RtParseSet (const char *cText, RTSET *RtSet);
+
+int RtSetup (const RTSET *RtSet);
+
+struct tagAsyncLog;
+
+int RtRun (const RTSET *RtSet, const SIMSET *SimSet, const CASESET *Case, struct tagAsyncLog *ALog, RTSTATS *Stats);
+
+void RtReport (const RTSET *RtSet, const RTSTATS *Stats);
+
+#endif // __RT_LOOP_H__
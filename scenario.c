@@ -0,0 +1,406 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "scenario.h"
+#include "data_treatment.h"
+#include "worker.h"
+#include "util_func.h"
+
+#define SCN_PATH_LEN   512   // maximum length of an output path
+
+// data shared by the scenario jobs
+typedef struct tagScenarioCtx {
+	const SCENARIO *Cases;
+	SCENARIORESULT *Results;
+	const char     *cOutDir;
+} SCENARIOCTX;
+
+
+/**
+*  -------------------------------------------------------  *
+*  PARSECASE() reads the simulation case from its name or
+*  its menu number.
+*  -------------------------------------------------------  *
+*/
+static int ParseCase (const char *cValue, short *sSimCase)
+{
+	const char *cNames[] = {"step", "tuned", "manual", "auto"};
+
+	short i;
+
+	for (i = 0; i < 4; i++)
+	{
+		if (strcmp(cValue, cNames[i]) == 0 || (cValue[0] == '1' + i && cValue[1] == '\0'))
+		{
+			*sSimCase = i;
+			return 0;
+		}
+	}
+
+	return -1;
+} // End: ParseCase()
+
+
+/**
+*  -------------------------------------------------------  *
+*  PARSELINE() fills a case from one line of key=value
+*  tokens. Keys that are not given keep their defaults.
+*  -------------------------------------------------------  *
+*/
+static int ParseLine (char *cLine, SCENARIO *Scn)
+{
+	char *cToken, *cValue, *cNum = NULL, *cDen = NULL;
+
+	for (cToken = strtok(cLine, " \t\r\n"); cToken != NULL; cToken = strtok(NULL, " \t\r\n"))
+	{
+		cValue = strchr(cToken, '=');
+		if (cValue == NULL)
+			return -1;
+
+		*cValue++ = '\0';
+
+		if (strcmp(cToken, "name") == 0)
+		{
+			strncpy(Scn->cName, cValue, SCN_NAME_LEN - 1);
+			Scn->cName[SCN_NAME_LEN - 1] = '\0';
+		}
+		else if (strcmp(cToken, "case") == 0)
+		{
+			if (ParseCase(cValue, &Scn->Case.sSimCase) != 0)
+				return -1;
+		}
+		else if (strcmp(cToken, "sp") == 0)
+			Scn->Case.sSetpoint = atof(cValue) * PREC;
+		else if (strcmp(cToken, "amp") == 0)
+			Scn->Case.fStepAmp = atof(cValue);
+		else if (strcmp(cToken, "delay") == 0)
+			Scn->Case.fStepDelay = max(atof(cValue), 0);
+		else if (strcmp(cToken, "K") == 0)
+			Scn->Case.PID.K = atof(cValue);
+		else if (strcmp(cToken, "Ti") == 0)
+			Scn->Case.PID.Ti = max(atof(cValue), eps);	// avoiding zero devision
+		else if (strcmp(cToken, "Td") == 0)
+			Scn->Case.PID.Td = max(atof(cValue), 0);
+		else if (strcmp(cToken, "N") == 0)
+			Scn->Case.PID.N = atoi(cValue);
+		else if (strcmp(cToken, "T") == 0)
+			Scn->fTsim = atof(cValue);
+		else if (strcmp(cToken, "Ts") == 0)
+			Scn->fTs = atof(cValue);
+		else if (strcmp(cToken, "num") == 0)
+			cNum = cValue;
+		else if (strcmp(cToken, "den") == 0)
+			cDen = cValue;
+		else if (strcmp(cToken, "c2d") == 0)
+		{
+			if (strcmp(cValue, "zoh") == 0)
+				Scn->sMethod = ZOH;
+			else if (strcmp(cValue, "tustin") == 0)
+				Scn->sMethod = TUSTIN;
+			else
+				return -1;
+		}
+		else
+			return -1;
+	}
+
+	if (Scn->fTs <= 0 || Scn->fTsim <= 0 || Scn->fTsim < Scn->fTs)
+		return -1;
+
+	/* the built-in difference equation only holds for SAMPLINGTIME */
+	if (cNum == NULL && cDen == NULL && fabs(Scn->fTs - SAMPLINGTIME) > eps)
+	{
+		cNum = SYS_NUM;
+		cDen = SYS_DEN;
+	}
+
+	if (cNum != NULL || cDen != NULL)
+	{
+		if (cNum == NULL || cDen == NULL || LtiParseTF(cNum, cDen, &Scn->Model) != 0)
+			return -1;
+
+		Scn->bModel = TRUE;
+	}
+
+	return 0;
+} // End: ParseLine()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SCENARIOREAD() reads a scenario file. Every non-empty
+*  line describes one case with key=value tokens:
+*
+*     name=<id> case=step|tuned|manual|auto sp=<set-point>
+*     amp=<step size> delay=<step delay> K=<gain> Ti=<int-
+*     egration time> Td=<derivative time> N=<filter> T=<h-
+*     orizon> Ts=<sampling time> num=<b0,b1,...> den=<a0,
+*     a1,...> c2d=zoh|tustin
+*
+*  num and den are the coefficients of a continuous plant
+*  G(s) in descending powers of s; the plant is discreti-
+*  zed at Ts with the c2d method. Text after '#' is a com-
+*  ment. Missing keys take the defaults of the interactive
+*  program (tuned gains, SIMTIME horizon, SAMPLINGTIME and
+*  the built-in plant).
+*
+*  Inputs:
+*     cFileName: name of the scenario file
+*
+*  Outputs:
+*     *Cases    : allocated array of cases (free() it)
+*     *uNbrCases: number of cases
+*     0 on success, -1 on failure
+*  -------------------------------------------------------  *
+*/
+int ScenarioRead (const char *cFileName, SCENARIO **Cases, unsigned *uNbrCases)
+{
+	FILE *file;
+
+	char cLine[SCN_LINE_LEN], *cComment;
+
+	unsigned uLine = 0, uCapacity = 16;
+
+	SCENARIO Scn, *NewCases;
+
+	file = fopen(cFileName, "r");
+	if (!file)
+	{
+		perror("Error opening file");
+		return -1;
+	}
+
+	*uNbrCases = 0;
+	*Cases     = malloc(sizeof(SCENARIO) * uCapacity);
+
+	if (*Cases == NULL)
+	{
+		puts("Error: memory allocaion failed!\n");
+		fclose(file);
+		return -1;
+	}
+
+	while (fgets(cLine, sizeof(cLine), file) != NULL)
+	{
+		uLine++;
+
+		cComment = strchr(cLine, '#');
+		if (cComment != NULL)
+			*cComment = '\0';
+
+		if (strspn(cLine, " \t\r\n") == strlen(cLine))
+			continue;
+
+		/* defaults */
+		memset(&Scn, 0, sizeof(Scn));
+		sprintf(Scn.cName, "case%03u", *uNbrCases + 1);
+		Scn.Case.sSimCase = TUNED;
+		Scn.fTsim         = SIMTIME;
+		Scn.fTs           = SAMPLINGTIME;
+		Scn.sMethod       = ZOH;
+		TunedPID(&Scn.Case.PID);
+
+		if (ParseLine(cLine, &Scn) != 0)
+		{
+			printf("Error: %s line %u is not a valid case!\n", cFileName, uLine);
+			free(*Cases);
+			*Cases = NULL;
+			fclose(file);
+			return -1;
+		}
+
+		if (*uNbrCases == uCapacity)
+		{
+			uCapacity *= 2;
+			NewCases   = realloc(*Cases, sizeof(SCENARIO) * uCapacity);
+
+			if (NewCases == NULL)
+			{
+				puts("Error: memory allocaion failed!\n");
+				free(*Cases);
+				*Cases = NULL;
+				fclose(file);
+				return -1;
+			}
+
+			*Cases = NewCases;
+		}
+
+		(*Cases)[(*uNbrCases)++] = Scn;
+	}
+
+	fclose(file);
+
+	return 0;
+} // End: ScenarioRead()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SCENARIOJOB() runs one case, scores it and saves its
+*  trajectory to <cOutDir>/<name>.dat.
+*  -------------------------------------------------------  *
+*/
+static void ScenarioJob (void *pCtx, unsigned uCase)
+{
+	SCENARIOCTX *Ctx = pCtx;
+
+	const SCENARIO *Scn = &Ctx->Cases[uCase];
+
+	SCENARIORESULT *Result = &Ctx->Results[uCase];
+
+	SIMSET SimSet;
+
+	CASESET Case;
+
+	LTIDISC Disc;
+
+	DATASET Traj;
+
+	char cPath[SCN_PATH_LEN];
+
+	float fReference;
+
+	unsigned i;
+
+	SimSet.fTs      = Scn->fTs;
+	SimSet.uNbrIter = Scn->fTsim / SimSet.fTs;
+
+	Case       = Scn->Case;
+	Case.Plant = NULL;
+
+	if (Scn->bModel)
+	{
+		Result->iStatus = LtiGetDisc(&Scn->Model, Scn->fTs, Scn->sMethod, &Disc);
+		if (Result->iStatus != 0)
+			return;
+
+		Case.Plant = &Disc;
+	}
+
+	Result->iStatus = DataSetAlloc(&Traj, SimSet.uNbrIter, TRUE);
+	if (Result->iStatus != 0)
+		return;
+
+	Result->PID = SimRun(&SimSet, &Case, &Traj, NULL, NULL);
+
+	/* step cases are scored against the step size */
+	if (Scn->Case.sSimCase == STEP)
+		fReference = Scn->Case.fStepAmp;
+	else
+		fReference = (float)Scn->Case.sSetpoint / PREC;
+
+	MetricsInit(&Result->Metrics, fReference);
+
+	for (i = 0; i < Traj.Length; i++)
+		MetricsUpdate(&Result->Metrics, Traj.Time[i], Traj.Output[i], SimSet.fTs);
+
+	MetricsFinish(&Result->Metrics, SimSet.fTs);
+
+	if (Ctx->cOutDir != NULL)
+	{
+		snprintf(cPath, sizeof(cPath), "%s/%s.dat", Ctx->cOutDir, Scn->cName);
+		Result->iStatus = SaveIOData(cPath, SimSet.fTs, &Traj);
+	}
+
+	FreeIOData(&Traj);
+
+} // End: ScenarioJob()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SCENARIORUN() runs all cases of a scenario without any
+*  user interaction, in parallel on a pool of threads. The
+*  trajectory of every case goes to <cOutDir>/<name>.dat
+*  and one summary line per case is printed and written to
+*  <cOutDir>/summary.txt.
+*
+*  Inputs:
+*     *Cases     : array of cases
+*     uNbrCases  : number of cases
+*     cOutDir    : output directory (NULL: no files)
+*     uNbrThreads: number of threads (0 uses all processors)
+*
+*  Outputs:
+*     0 if every case ran and was saved, -1 otherwise
+*  -------------------------------------------------------  *
+*/
+int ScenarioRun (
+		   const SCENARIO *Cases,
+		   unsigned uNbrCases,
+		   const char *cOutDir,
+		   unsigned uNbrThreads
+		   )
+{
+	SCENARIOCTX Ctx;
+
+	SCENARIORESULT *Results;
+
+	FILE *Summary = NULL;
+
+	char cPath[SCN_PATH_LEN], cLine[SCN_LINE_LEN];
+
+	double lfStart, lfElapsed;
+
+	unsigned i, uNbrFailed = 0;
+
+	Results = calloc(uNbrCases, sizeof(SCENARIORESULT));
+	if (Results == NULL)
+	{
+		puts("Error: memory allocaion failed!\n");
+		return -1;
+	}
+
+	Ctx.Cases   = Cases;
+	Ctx.Results = Results;
+	Ctx.cOutDir = cOutDir;
+
+	lfStart = WallClock();
+	WorkerRun(uNbrThreads, uNbrCases, ScenarioJob, &Ctx);
+	lfElapsed = WallClock() - lfStart;
+
+	if (cOutDir != NULL)
+	{
+		snprintf(cPath, sizeof(cPath), "%s/summary.txt", cOutDir);
+		Summary = fopen(cPath, "w");
+
+		if (!Summary)
+			perror("Error opening file");
+	}
+
+	sprintf(cLine, "%-16s %8s %8s %8s | %8s %8s %8s %8s %8s %8s\n",
+	        "case", "K", "Ti", "Td", "IAE", "ISE", "ITAE", "OS [%]", "Tr [s]", "Ts [s]");
+	fputs(cLine, stdout);
+	if (Summary)
+		fputs(cLine, Summary);
+
+	for (i = 0; i < uNbrCases; i++)
+	{
+		if (Results[i].iStatus != 0)
+		{
+			sprintf(cLine, "%-16s failed\n", Cases[i].cName);
+			uNbrFailed++;
+		}
+		else
+			sprintf(cLine, "%-16s %8.3f %8.3f %8.3f | %8.3f %8.3f %8.2f %8.2f %8.2f %8.2f\n",
+			        Cases[i].cName, Results[i].PID.K, Results[i].PID.Ti, Results[i].PID.Td,
+			        Results[i].Metrics.fIAE, Results[i].Metrics.fISE, Results[i].Metrics.fITAE,
+			        Results[i].Metrics.fOvershoot, Results[i].Metrics.fRiseTime, Results[i].Metrics.fSettleTime);
+
+		fputs(cLine, stdout);
+		if (Summary)
+			fputs(cLine, Summary);
+	}
+
+	if (Summary)
+		fclose(Summary);
+
+	printf("\n%u cases done in %.3f sec (%u failed)\n", uNbrCases, lfElapsed, uNbrFailed);
+
+	free(Results);
+
+	return (uNbrFailed > 0 || (cOutDir != NULL && Summary == NULL)) ? -1 : 0;
+} // End: ScenarioRun()
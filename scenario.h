@@ -0,0 +1,32 @@
+#ifndef __SCENARIO_H__
+#define __SCENARIO_H__
+
+#include "simulation.h"
+#include "metrics.h"
+
+#define SCN_NAME_LEN   32    // maximum length of a case name
+#define SCN_LINE_LEN   512   // maximum length of a line in a scenario file
+
+// one case of a scenario file
+typedef struct tagScenario {
+	char    cName[SCN_NAME_LEN];	// case name, also the output file name
+	CASESET Case;					// simulation case
+	float   fTsim;					// simulation horizon [sec]
+	float   fTs;					// sampling time [sec]
+	LTIMODEL Model;					// continuous plant (bModel)
+	unsigned char bModel;			// Model replaces Sys2ndOrder()
+	short   sMethod;				// discretization of Model, ZOH or TUSTIN
+} SCENARIO;
+
+// outcome of one case
+typedef struct tagScenarioResult {
+	PIDSET  PID;			// PID gains at the end of the run
+	METRICS Metrics;		// set-point response metrics
+	int     iStatus;		// 0 on success
+} SCENARIORESULT;
+
+int ScenarioRead (const char *cFileName, SCENARIO **Cases, unsigned *uNbrCases);
+
+int ScenarioRun (const SCENARIO *Cases, unsigned uNbrCases, const char *cOutDir, unsigned uNbrThreads);
+
+#endif // __SCENARIO_H__
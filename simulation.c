@@ -1,8 +1,32 @@
 #include "simulation.h"
 #include "control_system.h"
 #include "data_treatment.h"
+#include "live_plot.h"
 #include "util_func.h"
 
+/**
+*  -------------------------------------------------------  *
+*  PLANTINIT() initializes the memory of the plant.
+*
+*  Outputs:
+*     Plant: plant state at rest
+*  -------------------------------------------------------  *
+*/
+PLANTSTATE PlantInit (void)
+{
+	PLANTSTATE Plant;
+	
+	Plant.fY1Old = 0;
+	Plant.fY2Old = 0;
+	Plant.fY3Old = 0;
+	Plant.fU1Old = 0;
+	Plant.fU2Old = 0;
+	Plant.fU3Old = 0;
+	
+	return Plant;
+} // End: PlantInit()
+
+
 /**
 *  -------------------------------------------------------  *
 *  SYS2NDORDER() represents a second order linear dynamic- 
@@ -15,7 +39,8 @@
 *  It is discretized with an appropriate sampling time.
 *
 *  Inputs:
-*     sUin: plant input
+*     *Plant: pointer to the plant state
+*     sUin  : plant input
 *
 *  Outputs:
 *     sYout: plant output
@@ -24,40 +49,28 @@
 *          Jul. 2015
 *  -------------------------------------------------------  *
 */
-short Sys2ndOrder (unsigned char bReset, short sUin)
+short Sys2ndOrder (PLANTSTATE *Plant, short sUin)
 {
 	float fY;
 	
 	short sYout; 
 	
-	static float fY1Old, fY2Old, fY3Old, fU1Old, fU2Old, fU3Old;
-	
-	/* reset static variables for the next simulation. */
-	if (bReset)
-	{	fY1Old = 0;
-		fY2Old = 0;
-		fY3Old = 0;
-		fU1Old = 0;
-		fU2Old = 0;
-		fU3Old = 0;
-	}
-	
 	/* calculate the output
 	The transfer function has been discretized by sampling time of 0.1s */
 		 
-	fY = 2.8821 * fY1Old - 2.8068 * fY2Old + 0.9231 * fY3Old
- 	   + 0.0100 * fU1Old + 0.0010 * fU2Old - 0.0091 * fU3Old;
+	fY = SYS_A1 * Plant->fY1Old + SYS_A2 * Plant->fY2Old + SYS_A3 * Plant->fY3Old
+ 	   + SYS_B1 * Plant->fU1Old + SYS_B2 * Plant->fU2Old + SYS_B3 * Plant->fU3Old;
 	  
    /* update inputs */
-   fU3Old = fU2Old;
-   fU2Old = fU1Old;
-   fU1Old = (float)sUin / PREC;
-   fU1Old = sat(fU1Old, UMIN, UMAX);
+   Plant->fU3Old = Plant->fU2Old;
+   Plant->fU2Old = Plant->fU1Old;
+   Plant->fU1Old = (float)sUin / PREC;
+   Plant->fU1Old = sat(Plant->fU1Old, UMIN, UMAX);
    
    /* update inputs */
-   fY3Old = fY2Old;
-   fY2Old = fY1Old;
-   fY1Old = fY;
+   Plant->fY3Old = Plant->fY2Old;
+   Plant->fY2Old = Plant->fY1Old;
+   Plant->fY1Old = fY;
 	
 	sYout = fY * PREC;
 	
@@ -93,95 +106,302 @@ SIMSET SimInit (short sTsim)
 
 /**
 *  -------------------------------------------------------  *
-*  SIMULATION() simulates a discrete-time dynamical syste-
-*  m.
+*  LOOPINIT() prepares a closed loop for a new simulation.
 *
 *  Inputs:
-*     *SimSet    : structure of the simulation settings.
-*     cTuneMethod: if tuning required
-*     cFileName  : name of the file to save data into
+*     *Loop: pointer to the loop to initialize
+*     *Case: simulation case of the loop
+*  -------------------------------------------------------  *
+*/
+void LoopInit (LOOP *Loop, const CASESET *Case)
+{
+	Loop->Case    = *Case;
+	Loop->Plant   = PlantInit();
+	Loop->Lti     = LtiInit();
+	Loop->Ctrl    = PIDInit();
+	Loop->Tune    = TuneInit();
+	Loop->PID     = Case->PID;
+	Loop->Coef    = PIDCompile(&Case->PID, SAMPLINGTIME);
+	Loop->bTuned  = FALSE;
+	Loop->uIter   = 0;
+	Loop->sSysIn  = 0;
+	Loop->sSysOut = 0;
+	Loop->Rls     = NULL;
+	
+} // End: LoopInit()
+
+
+/**
+*  -------------------------------------------------------  *
+*  LOOPSTEP() advances a closed loop by one sample. The
+*  loop only touches its own memory, so any number of lo-
+*  ops can be stepped independently.
 *
-*  Author: S. Ehsan Shafiei
-*          Jul. 2015
+*  Inputs:
+*     *Loop  : pointer to the loop
+*     *SimSet: structure of the simulation settings
 *  -------------------------------------------------------  *
 */
-void simulation (SIMSET *SimSet, short sSimCase, const char *cFileName)
+void LoopStep (LOOP *Loop, const SIMSET *SimSet)
 {
-	/* simulation setting */
-	double time;
+	/* system response */
+	if (Loop->Case.Plant != NULL)
+		Loop->sSysOut = LtiStep(&Loop->Lti, Loop->Case.Plant, Loop->sSysIn);
+	else
+		Loop->sSysOut = Sys2ndOrder(&Loop->Plant, Loop->sSysIn);
 	
-	unsigned i;
+	/* track the ARX coefficients of the plant */
+	if (Loop->Rls != NULL)
+		RlsUpdate(Loop->Rls, sat((double)Loop->sSysIn / PREC, UMIN, UMAX), (double)Loop->sSysOut / PREC);
+	
+	LoopControl(Loop, SimSet);
+	
+} // End: LoopStep()
+
+
+/**
+*  -------------------------------------------------------  *
+*  LOOPCONTROL() is the controller half of LoopStep(): it
+*  computes the next plant input from Loop->sSysOut. Used
+*  directly when the plant runs elsewhere.
+*
+*  Inputs:
+*     *Loop  : pointer to the loop, sSysOut already updated
+*     *SimSet: structure of the simulation settings
+*  -------------------------------------------------------  *
+*/
+void LoopControl (LOOP *Loop, const SIMSET *SimSet)
+{
+	float fTime;
 	
-	short  sSysIn = 0, sSysOut = 0; 
+	fTime = Loop->uIter * SimSet->fTs;
 	
-	PIDSET PID;
+	if (!Loop->bTuned)
+	{
+		switch (Loop->Case.sSimCase)
+		{
+		   case STEP:
+		   	/* step input */
+				Loop->sSysIn = step(fTime, Loop->Case.fStepAmp, Loop->Case.fStepDelay);
+				break;
+				
+		   case TUNED:
+		   case MANUAL:
+		   	/* PID gains are given with the case */
+				Loop->bTuned = TRUE;
+				break;
+				
+	   	case AUTO:
+	   		/* controller automatic tuning */
+	   		Loop->sSysIn = AutoTune(&Loop->Tune, &Loop->bTuned, &Loop->PID, fTime, Loop->Case.sSetpoint, Loop->sSysOut, SimSet->fTs);
+				break;
+	   }
+	   
+	   /* the gains are fixed from now on */
+	   if (Loop->bTuned)
+	   	Loop->Coef = PIDCompile(&Loop->PID, SimSet->fTs);
+	}
+	else
+	{
+		Loop->sSysIn = PIDCtrl(&Loop->Ctrl, &Loop->Coef, Loop->Case.sSetpoint, Loop->sSysOut);
+	}
 	
-	unsigned char bTuned = FALSE; 
+	Loop->uIter++;
 	
-	unsigned char bReset = TRUE;
+} // End: LoopControl()
+
+
+/**
+*  -------------------------------------------------------  *
+*  LOOPSETPID() changes the PID gains of a running loop
+*  without a bump in the plant input.
+*
+*  Inputs:
+*     *Loop  : pointer to the loop
+*     *PID   : new PID gains
+*     *SimSet: structure of the simulation settings
+*  -------------------------------------------------------  *
+*/
+void LoopSetPID (LOOP *Loop, const PIDSET *PID, const SIMSET *SimSet)
+{
+	Loop->PID = *PID;
 	
-	/* set-point */
-	short sSetpoint;
+	PIDRetune(&Loop->Ctrl, &Loop->Coef, PID, SimSet->fTs);
 	
-	if (sSimCase != STEP)
-		sSetpoint = GetSetpoint();
+} // End: LoopSetPID()
+
+
+/**
+*  -------------------------------------------------------  *
+*  LOOPRUN() advances a set of independent closed loops.
+*
+*  Inputs:
+*     *Loops   : array of loops
+*     uNbrLoops: number of loops
+*     *SimSet  : structure of the simulation settings
+*     uNbrIter : number of samples to advance each loop
+*  -------------------------------------------------------  *
+*/
+void LoopRun (LOOP *Loops, unsigned uNbrLoops, const SIMSET *SimSet, unsigned uNbrIter)
+{
+	unsigned i, j;
 	
-	/* open a file to save data */
-	FILE *DataFile;
-	DataFile = fopen(cFileName, "w");
+	for (j = 0; j < uNbrLoops; j++)
+		for (i = 0; i < uNbrIter; i++)
+			LoopStep(&Loops[j], SimSet);
 	
-	/* main simulation loop */
-	for (i = 0; i < SimSet->uNbrIter; i++)
+} // End: LoopRun()
+
+
+/**
+*  -------------------------------------------------------  *
+*  LOOPRECORD() stores the last sample of a loop in a tra-
+*  jectory buffer.
+*
+*  Inputs:
+*     *Loop: pointer to the loop
+*     *Traj: trajectory buffer
+*     i    : sample index (below Traj->Capacity)
+*     time : time of the sample
+*  -------------------------------------------------------  *
+*/
+void LoopRecord (const LOOP *Loop, DATASET *Traj, unsigned i, double time)
+{
+	Traj->Time[i]   = time;
+	Traj->Input[i]  = (double)Loop->sSysIn  / PREC;
+	Traj->Output[i] = (double)Loop->sSysOut / PREC;
+	
+	if (Traj->Setpoint != NULL)
+		Traj->Setpoint[i] = (double)Loop->Case.sSetpoint / PREC;
+	
+	if (Traj->P != NULL)
+	{
+		Traj->P[i] = Loop->Ctrl.fP;
+		Traj->I[i] = Loop->Ctrl.fI;
+		Traj->D[i] = Loop->Ctrl.fD;
+	}
+	
+} // End: LoopRecord()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SIMRUN() runs one fully specified simulation case wit-
+*  hout any user interaction and fills a trajectory buf-
+*  fer.
+*
+*  Inputs:
+*     *SimSet: structure of the simulation settings
+*     *Case  : simulation case
+*     *Traj  : preallocated trajectory buffer to fill
+*     *Live  : live plot fed during the run (NULL: none)
+*     *Rls   : estimator run next to the loop (NULL: none)
+*
+*  Outputs:
+*     PID: PID gains at the end of the run
+*  -------------------------------------------------------  *
+*/
+PIDSET SimRun (const SIMSET *SimSet, const CASESET *Case, DATASET *Traj, LIVEPLOT *Live, RLSSTATE *Rls)
+{
+	double time;
+	
+	unsigned i, uNbrIter;
+	
+	LOOP Loop;
+	
+	LoopInit(&Loop, Case);
+	Loop.Rls = Rls;
+	
+	uNbrIter = min(SimSet->uNbrIter, Traj->Capacity);
+	
+	for (i = 0; i < uNbrIter; i++)
 	{
 		time = i * SimSet->fTs;
 		
-		/* system response */
-		sSysOut = Sys2ndOrder(bReset, sSysIn);
+		LoopStep(&Loop, SimSet);
 		
-		if (!bTuned)
-		{
-			switch (sSimCase)
-			{
-			   case STEP:
-			   	/* step input */
-					sSysIn = step(time);
-					break;
-					
-			   case TUNED:
-			   	/* an already tuned PID is used */
-					TunedPID(&PID);
-					bTuned = TRUE;
-					break;
-					
-			   case MANUAL:
-			   	/* PID gains is entered manually */
-			   	SetPIDParam(&PID);
-			   	bTuned = TRUE;
-					break;
-					
-		   	case AUTO:
-		   		/* controller automatic tuning */
-		   		sSysIn = AutoTune(&bTuned, &PID, time, sSetpoint, sSysOut, SimSet->fTs);
-					break;
-		   }
-		}
- 		else
+		/* keep data in the trajectory buffer */
+		LoopRecord(&Loop, Traj, i, time);
+		
+		/* show the run while it goes on */
+		if (Live != NULL && i % LIVE_CHECK == 0)
 		{
-			if (i < 2)
-				bReset = TRUE;
-			else
-			   bReset = FALSE;
-			   
-			sSysIn = PIDCtrl (bReset, &PID, sSetpoint, sSysOut, SimSet->fTs);
+			Traj->Length = i + 1;
+			LivePlotUpdate(Live, Traj, FALSE);
 		}
-		
-		bReset = FALSE;
-		/* save data into the file */
-		SaveData(DataFile, time, sSysIn, sSysOut);
 	}
 	
-	/* close the data file */
- 	fclose(DataFile);	
+	Traj->Length = uNbrIter;
+	
+	if (Live != NULL)
+		LivePlotUpdate(Live, Traj, TRUE);
+	
+	return Loop.PID;
+} // End: SimRun()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SIMULATION() simulates a discrete-time dynamical syste-
+*  m.
+*
+*  Inputs:
+*     *SimSet    : structure of the simulation settings.
+*     cTuneMethod: if tuning required
+*     *Traj      : preallocated trajectory buffer to fill
+*     cFileName  : name of the file to save data into (NULL
+*                  keeps the data in memory only)
+*     *Live      : live plot session (NULL: no live plot)
+*
+*  Author: S. Ehsan Shafiei
+*          Jul. 2015
+*  -------------------------------------------------------  *
+*/
+void simulation (SIMSET *SimSet, short sSimCase, DATASET *Traj, const char *cFileName, LIVEPLOT *Live)
+{
+	CASESET Case;
+	
+	RLSSTATE Rls;
+	
+	const double lfTrue[RLS_NBR_PAR] = {SYS_A1, SYS_A2, SYS_A3, SYS_B1, SYS_B2, SYS_B3};
+	
+	Case.sSimCase   = sSimCase;
+	Case.sSetpoint  = 0;
+	Case.fStepAmp   = 0;
+	Case.fStepDelay = 0;
+	Case.Plant      = NULL;
+	TunedPID(&Case.PID);
+	
+	/* set-point */
+	if (sSimCase != STEP)
+		Case.sSetpoint = GetSetpoint();
+	
+	switch (sSimCase)
+	{
+	   case STEP:
+	   	/* step input */
+	   	GetStepParam(&Case.fStepAmp, &Case.fStepDelay);
+	   	break;
+	   	
+	   case MANUAL:
+	   	/* PID gains is entered manually */
+	   	SetPIDParam(&Case.PID);
+	   	break;
+	}
+	
+	/* main simulation loop */
+	if (Live != NULL)
+		LivePlotReset(Live);
+	
+	Rls = RlsInit(RLS_LAMBDA);
+	
+	SimRun(SimSet, &Case, Traj, Live, &Rls);
+	
+	/* plant model identified on line */
+	RlsReport(&Rls, lfTrue);
+	
+	/* optionally save data into a file */
+	if (cFileName != NULL)
+		SaveIOData(cFileName, SimSet->fTs, Traj);
 	 	
 } // End: simulation()
-
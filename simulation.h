@@ -1,30 +1,100 @@
 #ifndef __SIMULATION_H__
 #define __SIMULATION_H__
 
+#include "control_system.h"
+#include "lti_plant.h"
+#include "rls.h"
+
 #define SIMTIME 		  100   // simulation time in sec
 #define SAMPLINGTIME   0.1   // simulation time in sec
 
 #define UMIN			 -3     // minimum input limit
 #define UMAX           3     // maximum input limit
 
+/* difference equation of G(s) discretized with Ts = 0.1s:
+   y(k) = A1 y(k-1) + A2 y(k-2) + A3 y(k-3) + B1 u(k-1) + B2 u(k-2) + B3 u(k-3) */
+#define SYS_A1         2.8821
+#define SYS_A2        -2.8068
+#define SYS_A3         0.9231
+#define SYS_B1         0.0100
+#define SYS_B2         0.0010
+#define SYS_B3        -0.0091
+
+/* coefficients of G(s), discretized at run time for other sampling times */
+#define SYS_NUM       "2,2"
+#define SYS_DEN       "1,0.8,4.2,1.616"
+
 enum SimCase
 {
 	STEP,		// 0
 	TUNED,	// 1
 	MANUAL,	// 2
-	AUTO		// 3
+	AUTO,		// 3
+	SWEEP,	// 4
+	OPTIMIZE	// 5
 };
 
 
-short Sys2ndOredr (unsigned char bReset, short u);
-
 typedef struct tagSimSet {
    float      fTs;		// sampling time
    unsigned   uNbrIter;	// number of iteration in the simulation loop	
 } SIMSET;
 
+// plant memory (one per control loop)
+typedef struct tagPlantState {
+	float fY1Old, fY2Old, fY3Old;	// past outputs
+	float fU1Old, fU2Old, fU3Old;	// past inputs
+} PLANTSTATE;
+
+// simulation case description
+typedef struct tagCaseSet {
+	short  sSimCase;		// STEP, TUNED, MANUAL or AUTO
+	short  sSetpoint;		// set-point
+	float  fStepAmp;		// step size (STEP case)
+	float  fStepDelay;		// step delay (STEP case)
+	PIDSET PID;				// PID gains (TUNED and MANUAL cases)
+	const LTIDISC *Plant;	// discretized plant, NULL uses Sys2ndOrder()
+} CASESET;
+
+// one closed loop: plant, controller and tuner
+typedef struct tagLoop {
+	CASESET       Case;		// simulation case
+	PLANTSTATE    Plant;		// plant memory
+	LTISTATE      Lti;		// plant memory (Case.Plant)
+	PIDSTATE      Ctrl;		// PID controller memory
+	TUNESTATE     Tune;		// relay tuner memory
+	PIDSET        PID;		// PID gains in use
+	PIDCOEF       Coef;		// compiled PID gains
+	unsigned char bTuned;	// PID gains are available
+	unsigned      uIter;		// number of steps taken
+	short         sSysIn;	// plant input
+	short         sSysOut;	// plant output
+	RLSSTATE     *Rls;		// online plant estimator, NULL: none
+} LOOP;
+
+PLANTSTATE PlantInit (void);
+
+short Sys2ndOrder (PLANTSTATE *Plant, short sUin);
+
 SIMSET SimInit (short sTsim);
 
-void simulation (SIMSET *SimSet, short sSimCase, const char *cFileName);
+void LoopInit (LOOP *Loop, const CASESET *Case);
+
+void LoopStep (LOOP *Loop, const SIMSET *SimSet);
+
+void LoopControl (LOOP *Loop, const SIMSET *SimSet);
+
+void LoopSetPID (LOOP *Loop, const PIDSET *PID, const SIMSET *SimSet);
+
+void LoopRun (LOOP *Loops, unsigned uNbrLoops, const SIMSET *SimSet, unsigned uNbrIter);
+
+struct tagDataSet;
+struct tagLivePlot;
+
+void LoopRecord (const LOOP *Loop, struct tagDataSet *Traj, unsigned i, double time);
+
+PIDSET SimRun (const SIMSET *SimSet, const CASESET *Case, struct tagDataSet *Traj, struct tagLivePlot *Live, RLSSTATE *Rls);
+
+void simulation (SIMSET *SimSet, short sSimCase, struct tagDataSet *Traj, const char *cFileName, struct tagLivePlot *Live);
 
 #endif // __SIMULATION_H__
@@ -0,0 +1,347 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sweep.h"
+#include "batch_sim.h"
+#include "worker.h"
+#include "util_func.h"
+
+#define SWEEPBEST    10            // number of best candidates to report
+#define SWEEPCHUNK   BATCH_BLOCK   // grid points stepped together by one job
+
+// data shared by the sweep jobs
+typedef struct tagSweepCtx {
+	const SIMSET    *SimSet;
+	const SWEEPGRID *Grid;
+	SWEEPRESULT     *Results;
+	unsigned         uNbrPoints;	// SweepSize() of the grid
+} SWEEPCTX;
+
+
+/**
+*  -------------------------------------------------------  *
+*  AXISVALUE() returns the i-th value of a grid axis.
+*  -------------------------------------------------------  *
+*/
+static float AxisValue (const SWEEPAXIS *Axis, unsigned i)
+{
+	if (Axis->uNbr < 2)
+		return Axis->fMin;
+
+	return Axis->fMin + (Axis->fMax - Axis->fMin) * i / (Axis->uNbr - 1);
+} // End: AxisValue()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SWEEPSIZE() returns the number of points in the grid.
+*
+*  Inputs:
+*     *Grid: pointer to the gain grid
+*  -------------------------------------------------------  *
+*/
+unsigned SweepSize (const SWEEPGRID *Grid)
+{
+	return max(Grid->K.uNbr, 1) * max(Grid->Ti.uNbr, 1) * max(Grid->Td.uNbr, 1) * max(Grid->N.uNbr, 1);
+} // End: SweepSize()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SWEEPPOINT() returns the PID gains of a grid point.
+*
+*  Inputs:
+*     *Grid : pointer to the gain grid
+*     uPoint: index of the point
+*
+*  Outputs:
+*     PID: PID gains of the point
+*  -------------------------------------------------------  *
+*/
+PIDSET SweepPoint (const SWEEPGRID *Grid, unsigned uPoint)
+{
+	PIDSET PID;
+
+	unsigned uNbrK, uNbrTi, uNbrTd;
+
+	uNbrK  = max(Grid->K.uNbr , 1);
+	uNbrTi = max(Grid->Ti.uNbr, 1);
+	uNbrTd = max(Grid->Td.uNbr, 1);
+
+	PID.K  = AxisValue(&Grid->K, uPoint % uNbrK);
+	uPoint /= uNbrK;
+	PID.Ti = AxisValue(&Grid->Ti, uPoint % uNbrTi);
+	uPoint /= uNbrTi;
+	PID.Td = AxisValue(&Grid->Td, uPoint % uNbrTd);
+	uPoint /= uNbrTd;
+	PID.N  = AxisValue(&Grid->N, uPoint);
+
+	PID.Ti = max(PID.Ti, eps);	// avoiding zero devision
+	PID.Td = max(PID.Td, 0  );
+
+	return PID;
+} // End: SweepPoint()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SWEEPLOOP() runs the closed loop of one grid point with
+*  LoopStep() and scores its response. Used when a batch
+*  cannot be allocated.
+*  -------------------------------------------------------  *
+*/
+static void SweepLoop (SWEEPCTX *Ctx, unsigned uPoint)
+{
+	const SIMSET *SimSet = Ctx->SimSet;
+
+	CASESET Case;
+
+	LOOP Loop;
+
+	METRICS Metrics;
+
+	unsigned i;
+
+	Case.sSimCase   = MANUAL;
+	Case.sSetpoint  = Ctx->Grid->sSetpoint;
+	Case.fStepAmp   = 0;
+	Case.fStepDelay = 0;
+	Case.PID        = SweepPoint(Ctx->Grid, uPoint);
+	Case.Plant      = NULL;
+
+	LoopInit(&Loop, &Case);
+	MetricsInit(&Metrics, (float)Case.sSetpoint / PREC);
+
+	for (i = 0; i < SimSet->uNbrIter; i++)
+	{
+		LoopStep(&Loop, SimSet);
+		MetricsUpdate(&Metrics, i * SimSet->fTs, (float)Loop.sSysOut / PREC, SimSet->fTs);
+	}
+
+	MetricsFinish(&Metrics, SimSet->fTs);
+
+	Ctx->Results[uPoint].PID     = Case.PID;
+	Ctx->Results[uPoint].Metrics = Metrics;
+
+} // End: SweepLoop()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SWEEPJOB() runs the closed loops of SWEEPCHUNK grid po-
+*  ints side by side with BatchStep() and scores their re-
+*  sponses.
+*  -------------------------------------------------------  *
+*/
+static void SweepJob (void *pCtx, unsigned uJob)
+{
+	SWEEPCTX *Ctx = pCtx;
+
+	const SIMSET *SimSet = Ctx->SimSet;
+
+	BATCHSIM Batch;
+
+	METRICS Metrics[SWEEPCHUNK];
+
+	PIDSET PID;
+
+	unsigned i, j, uFirst, uNbr;
+
+	float fSetpoint;
+
+	uFirst = uJob * SWEEPCHUNK;
+	uNbr   = min(SWEEPCHUNK, Ctx->uNbrPoints - uFirst);
+
+	if (BatchInit(&Batch, uNbr) != 0)
+	{
+		for (j = 0; j < uNbr; j++)
+			SweepLoop(Ctx, uFirst + j);
+		return;
+	}
+
+	fSetpoint = (float)Ctx->Grid->sSetpoint / PREC;
+
+	for (j = 0; j < uNbr; j++)
+	{
+		PID = SweepPoint(Ctx->Grid, uFirst + j);
+		BatchSetLoop(&Batch, j, &PID, fSetpoint, SimSet->fTs);
+		MetricsInit(&Metrics[j], fSetpoint);
+
+		Ctx->Results[uFirst + j].PID = PID;
+	}
+
+	/* as in LoopStep(), the first sample only switches the controllers on */
+	for (j = 0; j < uNbr && SimSet->uNbrIter > 0; j++)
+		MetricsUpdate(&Metrics[j], 0, 0, SimSet->fTs);
+
+	for (i = 1; i < SimSet->uNbrIter; i++)
+	{
+		BatchStep(&Batch, 1);
+
+		for (j = 0; j < uNbr; j++)
+			MetricsUpdate(&Metrics[j], i * SimSet->fTs, Batch.fY[j], SimSet->fTs);
+	}
+
+	for (j = 0; j < uNbr; j++)
+	{
+		MetricsFinish(&Metrics[j], SimSet->fTs);
+		Ctx->Results[uFirst + j].Metrics = Metrics[j];
+	}
+
+	BatchFree(&Batch);
+
+} // End: SweepJob()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SWEEP() evaluates every point of a gain grid with the
+*  closed loop of simulation() on a pool of threads. Each
+*  job steps SWEEPCHUNK candidates at once with the batch
+*  kernel (batch_sim.h), which reproduces the PREC trunca-
+*  tion of the scalar loop sample for sample, so the
+*  scores are those of LoopStep(). Nothing is written to
+*  disk.
+*
+*  Inputs:
+*     *SimSet    : structure of the simulation settings
+*     *Grid      : pointer to the gain grid
+*     uNbrThreads: number of threads (0 uses all processors)
+*
+*  Outputs:
+*     *Results: one result per grid point (SweepSize())
+*  -------------------------------------------------------  *
+*/
+void Sweep (
+		   const SIMSET *SimSet,
+		   const SWEEPGRID *Grid,
+		   SWEEPRESULT *Results,
+		   unsigned uNbrThreads
+		   )
+{
+	SWEEPCTX Ctx;
+
+	Ctx.SimSet     = SimSet;
+	Ctx.Grid       = Grid;
+	Ctx.Results    = Results;
+	Ctx.uNbrPoints = SweepSize(Grid);
+
+	WorkerRun(uNbrThreads, (Ctx.uNbrPoints + SWEEPCHUNK - 1) / SWEEPCHUNK, SweepJob, &Ctx);
+
+} // End: Sweep()
+
+
+/**
+*  -------------------------------------------------------  *
+*  COMPAREIAE() orders sweep results by increasing IAE.
+*  -------------------------------------------------------  *
+*/
+static int CompareIAE (const void *pA, const void *pB)
+{
+	const SWEEPRESULT *A = pA, *B = pB;
+
+	if (A->Metrics.fIAE < B->Metrics.fIAE)
+		return -1;
+
+	return A->Metrics.fIAE > B->Metrics.fIAE;
+} // End: CompareIAE()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SWEEPREPORT() sorts the sweep results by IAE and prints
+*  the best ones.
+*
+*  Inputs:
+*     *Results   : sweep results
+*     uNbrResults: number of results
+*     uNbrBest   : number of results to print
+*  -------------------------------------------------------  *
+*/
+void SweepReport (SWEEPRESULT *Results, unsigned uNbrResults, unsigned uNbrBest)
+{
+	unsigned i;
+
+	qsort(Results, uNbrResults, sizeof(SWEEPRESULT), CompareIAE);
+
+	printf("%8s %8s %8s %5s | %8s %8s %8s %8s %8s %8s\n",
+	       "K", "Ti", "Td", "N", "IAE", "ISE", "ITAE", "OS [%]", "Tr [s]", "Ts [s]");
+
+	for (i = 0; i < min(uNbrBest, uNbrResults); i++)
+	{
+		printf("%8.3f %8.3f %8.3f %5d | %8.3f %8.3f %8.2f %8.2f %8.2f %8.2f\n",
+		       Results[i].PID.K, Results[i].PID.Ti, Results[i].PID.Td, Results[i].PID.N,
+		       Results[i].Metrics.fIAE, Results[i].Metrics.fISE, Results[i].Metrics.fITAE,
+		       Results[i].Metrics.fOvershoot, Results[i].Metrics.fRiseTime, Results[i].Metrics.fSettleTime);
+	}
+
+} // End: SweepReport()
+
+
+/**
+*  -------------------------------------------------------  *
+*  GETAXIS() gets the range of a grid axis from user.
+*  -------------------------------------------------------  *
+*/
+static void GetAxis (const char *cName, SWEEPAXIS *Axis)
+{
+	int iNbr;
+
+	printf("Enter %s as: min max number_of_values\n", cName);
+	scanf("%f %f %i", &Axis->fMin, &Axis->fMax, &iNbr);
+	fflush(stdin);
+
+	Axis->uNbr = max(iNbr, 1);
+
+} // End: GetAxis()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SWEEPSESSION() asks user for a gain grid, sweeps it
+*  and reports the best PID gains.
+*
+*  Inputs:
+*     *SimSet: structure of the simulation settings
+*  -------------------------------------------------------  *
+*/
+void SweepSession (const SIMSET *SimSet)
+{
+	SWEEPGRID Grid;
+
+	SWEEPRESULT *Results;
+
+	unsigned uNbrPoints, uNbrThreads;
+
+	double lfStart, lfElapsed;
+
+	Grid.sSetpoint = GetSetpoint();
+
+	GetAxis("PID gain K", &Grid.K);
+	GetAxis("integration time Ti", &Grid.Ti);
+	GetAxis("derivative time Td", &Grid.Td);
+	GetAxis("derivative filter factor N", &Grid.N);
+
+	uNbrPoints = SweepSize(&Grid);
+	Results    = malloc(sizeof(SWEEPRESULT) * uNbrPoints);
+
+	if (Results == NULL)
+	{
+		puts("Error: memory allocaion failed!\n");
+		return;
+	}
+
+	uNbrThreads = WorkerCount();
+
+	lfStart = WallClock();
+	Sweep(SimSet, &Grid, Results, uNbrThreads);
+	lfElapsed = WallClock() - lfStart;
+
+	printf("%u candidates scored in %.3f sec on %u threads (%.0f candidates/sec)\n\n",
+	       uNbrPoints, lfElapsed, uNbrThreads, uNbrPoints / max(lfElapsed, eps));
+
+	SweepReport(Results, uNbrPoints, SWEEPBEST);
+
+	free(Results);
+
+} // End: SweepSession()
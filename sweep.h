@@ -0,0 +1,36 @@
+#ifndef __SWEEP_H__
+#define __SWEEP_H__
+
+#include "simulation.h"
+#include "metrics.h"
+
+// one axis of the gain grid
+typedef struct tagSweepAxis {
+	float    fMin;	// first value
+	float    fMax;	// last value
+	unsigned uNbr;	// number of values (1 uses fMin only)
+} SWEEPAXIS;
+
+// grid over the PID gains
+typedef struct tagSweepGrid {
+	SWEEPAXIS K, Ti, Td, N;
+	short     sSetpoint;	// set-point of every candidate
+} SWEEPGRID;
+
+// scored candidate
+typedef struct tagSweepResult {
+	PIDSET  PID;
+	METRICS Metrics;
+} SWEEPRESULT;
+
+unsigned SweepSize (const SWEEPGRID *Grid);
+
+PIDSET SweepPoint (const SWEEPGRID *Grid, unsigned uPoint);
+
+void Sweep (const SIMSET *SimSet, const SWEEPGRID *Grid, SWEEPRESULT *Results, unsigned uNbrThreads);
+
+void SweepReport (SWEEPRESULT *Results, unsigned uNbrResults, unsigned uNbrBest);
+
+void SweepSession (const SIMSET *SimSet);
+
+#endif // __SWEEP_H__
@@ -0,0 +1,840 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "sysid.h"
+#include "util_func.h"
+#include "worker.h"
+
+#define SYSID_MAXPAR   5       // largest regression (SOPDT least squares)
+#define SYSID_MAXFIT   20000   // samples of the coarse Gauss-Newton iterations
+#define SYSID_TOL      1e-8    // relative error decrease ending the iterations
+
+// step experiment found in a log
+typedef struct tagStepData {
+	const double *Time;		// time of every sample
+	const double *Output;	// plant output of every sample
+	unsigned uFirst;		// first sample of the step
+	unsigned uLast;			// one past the last sample
+	unsigned uSettle;		// one past the transient and its margin
+	unsigned uStride;		// sample stride of the output error in the transient
+	double   lfT0;			// time of the step
+	double   lfU;			// input step size
+	double   lfY0;			// output before the step
+	double   lfDeltaY;		// output change at the end of the log
+} STEPDATA;
+
+// both model fits of a report, one per worker job
+typedef struct tagSysIdCtx {
+	const DATASET *Data;
+	SYSIDMODEL     Model[2];	// FOPDT, SOPDT
+	int            iStatus[2];
+} SYSIDCTX;
+
+
+/**
+*  -------------------------------------------------------  *
+*  STEPFIND() finds the input step of a log, the output
+*  level before it and the output change at the end, and
+*  the transient: from the response start (SYSID_START) to
+*  the end (SYSID_END) plus SYSID_MARGIN of its length.
+*  -------------------------------------------------------  *
+*/
+static int StepFind (const DATASET *Data, STEPDATA *Step)
+{
+	unsigned i, uTail;
+
+	double lfU0, y, lfTStart = -1, lfTStop = -1;
+
+	if (Data->Length < 10)
+	{
+		puts("Error: the log is too short to identify a model!\n");
+		return -1;
+	}
+
+	lfU0      = Data->Input[0];
+	Step->lfU = Data->Input[Data->Length - 1] - lfU0;
+
+	if (fabs(Step->lfU) < eps)
+	{
+		puts("Error: there is no step in the input!\n");
+		return -1;
+	}
+
+	for (i = 0; fabs(Data->Input[i] - lfU0) < 0.5 * fabs(Step->lfU); i++)
+		;
+
+	Step->Time   = Data->Time;
+	Step->Output = Data->Output;
+	Step->uFirst = i;
+	Step->uLast  = Data->Length;
+	Step->lfT0   = Data->Time[i];
+
+	/* output level before the step, and at the end of the log */
+	Step->lfY0 = Data->Output[0];
+	if (i > 0)
+	{
+		for (i = 1, Step->lfY0 = Data->Output[0]; i < Step->uFirst; i++)
+			Step->lfY0 += Data->Output[i];
+
+		Step->lfY0 /= Step->uFirst;
+	}
+
+	uTail = max(Data->Length / 20, 1);
+
+	for (i = Data->Length - uTail, Step->lfDeltaY = 0; i < Data->Length; i++)
+		Step->lfDeltaY += Data->Output[i] / uTail;
+
+	Step->lfDeltaY -= Step->lfY0;
+
+	if (fabs(Step->lfDeltaY) < eps)
+	{
+		puts("Error: the output does not respond to the step!\n");
+		return -1;
+	}
+
+	for (i = Step->uFirst; i < Step->uLast; i++)
+	{
+		y = fabs(Data->Output[i] - Step->lfY0);
+
+		if (lfTStart < 0 && y >= SYSID_START * fabs(Step->lfDeltaY))
+			lfTStart = Data->Time[i];
+
+		if (lfTStart >= 0 && lfTStop < 0 && y >= SYSID_END * fabs(Step->lfDeltaY))
+			lfTStop = Data->Time[i] + SYSID_MARGIN * (Data->Time[i] - lfTStart);
+
+		if (lfTStop >= 0 && Data->Time[i] > lfTStop)
+			break;
+	}
+
+	Step->uSettle = i;
+	Step->uStride = max((Step->uSettle - Step->uFirst) / SYSID_MAXFIT, 1);
+
+	return 0;
+} // End: StepFind()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SOLVESYM() solves the symmetric system A x = b in place
+*  (b becomes x) by Gaussian elimination with partial pi-
+*  voting, after scaling A to a unit diagonal.
+*  -------------------------------------------------------  *
+*/
+static int SolveSym (double *A, double *b, unsigned n)
+{
+	double lfScale[SYSID_MAXPAR], lfPivot, lfTmp;
+
+	unsigned i, j, k, p;
+
+	for (i = 0; i < n; i++)
+		lfScale[i] = (A[i * n + i] > 0) ? 1 / sqrt(A[i * n + i]) : 1;
+
+	for (i = 0; i < n; i++)
+	{
+		b[i] *= lfScale[i];
+		for (j = 0; j < n; j++)
+			A[i * n + j] *= lfScale[i] * lfScale[j];
+	}
+
+	for (k = 0; k < n; k++)
+	{
+		for (i = k + 1, p = k; i < n; i++)
+			if (fabs(A[i * n + k]) > fabs(A[p * n + k]))
+				p = i;
+
+		if (fabs(A[p * n + k]) < 1e-14)
+			return -1;
+
+		if (p != k)
+		{
+			for (j = 0; j < n; j++)
+			{
+				lfTmp = A[k * n + j]; A[k * n + j] = A[p * n + j]; A[p * n + j] = lfTmp;
+			}
+			lfTmp = b[k]; b[k] = b[p]; b[p] = lfTmp;
+		}
+
+		for (i = k + 1; i < n; i++)
+		{
+			lfPivot = A[i * n + k] / A[k * n + k];
+
+			for (j = k; j < n; j++)
+				A[i * n + j] -= lfPivot * A[k * n + j];
+			b[i] -= lfPivot * b[k];
+		}
+	}
+
+	for (k = n; k-- > 0; )
+	{
+		for (j = k + 1; j < n; j++)
+			b[k] -= A[k * n + j] * b[j];
+		b[k] /= A[k * n + k];
+	}
+
+	for (i = 0; i < n; i++)
+		b[i] *= lfScale[i];
+
+	return 0;
+} // End: SolveSym()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SYSIDLEASTSQUARES() gets a first model from one linear
+*  regression. Integrating the model equation from the
+*  step on (t after the step, Y and U the output and in-
+*  put changes) gives, after the dead time,
+*
+*     FOPDT: Y = -1/T1 I1 + K U/T1 (t - theta)
+*     SOPDT: Y = -(T1 + T2)/(T1 T2) I1 - 1/(T1 T2) I2
+*                + K U/(2 T1 T2) (t - theta)^2
+*
+*  with I1 and I2 the single and double integrals of Y,
+*  linear in the unknown coefficients. The samples are
+*  used from the response start (SYSID_START) to the end
+*  of the transient found by StepFind(): on a long flat
+*  tail the regressors t, t^2 and I2 grow without bound
+*  and would swamp the transient.
+*  -------------------------------------------------------  *
+*/
+static int SysIdLeastSquares (const STEPDATA *Step, short sOrder, double *lfPar)
+{
+	double A[SYSID_MAXPAR * SYSID_MAXPAR], b[SYSID_MAXPAR], lfPhi[SYSID_MAXPAR];
+
+	double t, y, lfYOld = 0, lfI1 = 0, lfI1Old, lfI2 = 0, lfDt, lfProd, lfSum, lfDisc;
+
+	unsigned i, j, k, n;
+
+	unsigned char bStarted = FALSE;
+
+	n = (sOrder == FOPDT) ? 3 : 5;
+
+	memset(A, 0, sizeof(A));
+	memset(b, 0, sizeof(b));
+
+	for (i = Step->uFirst; i < Step->uSettle; i++)
+	{
+		t = Step->Time[i] - Step->lfT0;
+		y = Step->Output[i] - Step->lfY0;
+
+		if (i > Step->uFirst)
+		{
+			lfDt    = Step->Time[i] - Step->Time[i - 1];
+			lfI1Old = lfI1;
+			lfI1   += 0.5 * (lfYOld + y) * lfDt;
+			lfI2   += 0.5 * (lfI1Old + lfI1) * lfDt;
+		}
+		lfYOld = y;
+
+		if (!bStarted && fabs(y) < SYSID_START * fabs(Step->lfDeltaY))
+			continue;
+
+		bStarted = TRUE;
+
+		if (sOrder == FOPDT)
+		{
+			lfPhi[0] = lfI1; lfPhi[1] = t; lfPhi[2] = 1;
+		}
+		else
+		{
+			lfPhi[0] = lfI1; lfPhi[1] = lfI2; lfPhi[2] = t * t; lfPhi[3] = t; lfPhi[4] = 1;
+		}
+
+		for (j = 0; j < n; j++)
+		{
+			b[j] += lfPhi[j] * y;
+			for (k = 0; k <= j; k++)
+				A[j * n + k] += lfPhi[j] * lfPhi[k];
+		}
+	}
+
+	for (j = 0; j < n; j++)
+		for (k = j + 1; k < n; k++)
+			A[j * n + k] = A[k * n + j];
+
+	if (SolveSym(A, b, n) != 0)
+		return -1;
+
+	if (sOrder == FOPDT)
+	{
+		if (b[0] >= 0 || b[1] == 0)
+			return -1;
+
+		lfPar[1] = -1 / b[0];						// T1
+		lfPar[0] = b[1] * lfPar[1] / Step->lfU;	// K
+		lfPar[2] = max(-b[2] / b[1], 0);			// theta
+	}
+	else
+	{
+		if (b[1] >= 0 || b[2] == 0)
+			return -1;
+
+		lfProd = -1 / b[1];		// T1 T2
+		lfSum  = -b[0] * lfProd;	// T1 + T2
+		lfDisc = lfSum * lfSum - 4 * lfProd;
+
+		if (lfSum <= 0)
+			return -1;
+
+		/* complex poles are replaced by a double pole */
+		lfPar[1] = (lfDisc > 0) ? 0.5 * (lfSum + sqrt(lfDisc)) : sqrt(lfProd);
+		lfPar[2] = (lfDisc > 0) ? 0.5 * (lfSum - sqrt(lfDisc)) : sqrt(lfProd);
+		lfPar[0] = 2 * b[2] * lfProd / Step->lfU;
+		lfPar[3] = max(-b[3] / (2 * b[2]), 0);
+	}
+
+	return 0;
+} // End: SysIdLeastSquares()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SYSIDRESPONSE() returns the step response of a model at
+*  time t after the step and, if lfGrad is not NULL, its
+*  derivatives with respect to the parameters:
+*     FOPDT: {K, T1, theta}, SOPDT: {K, T1, T2, theta}
+*  -------------------------------------------------------  *
+*/
+static double SysIdResponse (const double *lfPar, short sOrder, double lfU, double t, double *lfGrad)
+{
+	double lfKU, lfT1, lfT2, e1, e2, d, lfNum, s;
+
+	lfKU = lfPar[0] * lfU;
+	lfT1 = lfPar[1];
+	t   -= lfPar[sOrder + 1];		// time after the dead time
+
+	if (t <= 0)
+	{
+		if (lfGrad)
+			memset(lfGrad, 0, sizeof(double) * (sOrder + 2));
+		return 0;
+	}
+
+	e1 = exp(-t / lfT1);
+
+	if (sOrder == FOPDT)
+	{
+		s = 1 - e1;
+
+		if (lfGrad)
+		{
+			lfGrad[0] = lfU * s;
+			lfGrad[1] = -lfKU * e1 * t / (lfT1 * lfT1);
+			lfGrad[2] = -lfKU * e1 / lfT1;
+		}
+	}
+	else
+	{
+		lfT2  = lfPar[2];
+		e2    = exp(-t / lfT2);
+		d     = lfT1 - lfT2;
+		lfNum = lfT1 * e1 - lfT2 * e2;
+		s     = 1 - lfNum / d;
+
+		if (lfGrad)
+		{
+			lfGrad[0] = lfU * s;
+			lfGrad[1] = -lfKU * (e1 * (1 + t / lfT1) * d - lfNum) / (d * d);
+			lfGrad[2] = -lfKU * (lfNum - e2 * (1 + t / lfT2) * d) / (d * d);
+			lfGrad[3] = -lfKU * (e1 - e2) / d;
+		}
+	}
+
+	return lfKU * s;
+} // End: SysIdResponse()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SYSIDCONSTRAIN() keeps the parameters physical: posi-
+*  tive time constants, T1 > T2 (the poles of a SOPDT are
+*  interchangeable, and distinct for the response formula)
+*  and a non-negative dead time.
+*  -------------------------------------------------------  *
+*/
+static void SysIdConstrain (double *lfPar, const double *lfOld, short sOrder)
+{
+	double lfTmp;
+
+	unsigned i;
+
+	for (i = 1; i <= (unsigned)sOrder; i++)
+		if (lfPar[i] <= 0)
+			lfPar[i] = 0.5 * lfOld[i];
+
+	lfPar[sOrder + 1] = max(lfPar[sOrder + 1], 0);
+
+	if (sOrder == SOPDT)
+	{
+		if (lfPar[2] > lfPar[1])
+		{
+			lfTmp = lfPar[1]; lfPar[1] = lfPar[2]; lfPar[2] = lfTmp;
+		}
+
+		if (lfPar[1] - lfPar[2] < 1e-4 * lfPar[1])
+			lfPar[2] = lfPar[1] * (1 - 1e-4);
+	}
+
+} // End: SysIdConstrain()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SYSIDSSE() returns the sum of squared output errors of
+*  a model over every uStride-th sample of the step, and
+*  its normal equations if A is not NULL.
+*  -------------------------------------------------------  *
+*/
+static double SysIdSse (const STEPDATA *Step, const double *lfPar, short sOrder, double *A, double *b)
+{
+	double lfGrad[SYSID_MAXPAR], r, lfSse = 0;
+
+	unsigned i, j, k, n;
+
+	n = sOrder + 2;
+
+	if (A != NULL)
+	{
+		memset(A, 0, sizeof(double) * n * n);
+		memset(b, 0, sizeof(double) * n);
+	}
+
+	for (i = Step->uFirst; i < Step->uLast; i += Step->uStride)
+	{
+		r = Step->Output[i] - Step->lfY0
+		  - SysIdResponse(lfPar, sOrder, Step->lfU, Step->Time[i] - Step->lfT0, (A != NULL) ? lfGrad : NULL);
+
+		lfSse += r * r;
+
+		if (A != NULL)
+		{
+			for (j = 0; j < n; j++)
+			{
+				b[j] += lfGrad[j] * r;
+				for (k = 0; k <= j; k++)
+					A[j * n + k] += lfGrad[j] * lfGrad[k];
+			}
+		}
+	}
+
+	if (A != NULL)
+		for (j = 0; j < n; j++)
+			for (k = j + 1; k < n; k++)
+				A[j * n + k] = A[k * n + j];
+
+	return lfSse;
+} // End: SysIdSse()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SYSIDGAUSSNEWTON() takes one Gauss-Newton step on the
+*  output error, with the Levenberg damping raised (up to
+*  uMaxTry times) until the error decreases.
+*
+*  Outputs:
+*     relative decrease of the error, -1 if no step found
+*  -------------------------------------------------------  *
+*/
+static double SysIdGaussNewton (const STEPDATA *Step, short sOrder, double *lfPar, double *lfLambda, unsigned uMaxTry)
+{
+	double A[SYSID_MAXPAR * SYSID_MAXPAR], b[SYSID_MAXPAR], M[SYSID_MAXPAR * SYSID_MAXPAR], x[SYSID_MAXPAR];
+
+	double lfNew[SYSID_MAXPAR], lfSse, lfSseNew;
+
+	unsigned j, n, uTry;
+
+	n = sOrder + 2;
+
+	lfSse = SysIdSse(Step, lfPar, sOrder, A, b);
+
+	for (uTry = 0; uTry < uMaxTry; uTry++, *lfLambda *= 10)
+	{
+		memcpy(M, A, sizeof(M));
+		memcpy(x, b, sizeof(x));
+
+		for (j = 0; j < n; j++)
+			M[j * n + j] *= 1 + *lfLambda;
+
+		if (SolveSym(M, x, n) != 0)
+			continue;
+
+		for (j = 0; j < n; j++)
+			lfNew[j] = lfPar[j] + x[j];
+
+		SysIdConstrain(lfNew, lfPar, sOrder);
+
+		lfSseNew = SysIdSse(Step, lfNew, sOrder, NULL, NULL);
+
+		if (lfSseNew < lfSse)
+		{
+			memcpy(lfPar, lfNew, sizeof(double) * n);
+			*lfLambda = max(*lfLambda / 100, 1e-9);
+
+			return (lfSse - lfSseNew) / lfSse;
+		}
+	}
+
+	return -1;
+} // End: SysIdGaussNewton()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SYSIDSTART() gets the starting point of the iterations
+*  from SysIdLeastSquares(), or a crude guess if the re-
+*  gression fails.
+*  -------------------------------------------------------  *
+*/
+static void SysIdStart (const STEPDATA *Step, short sOrder, double *lfPar)
+{
+	if (SysIdLeastSquares(Step, sOrder, lfPar) != 0)
+	{
+		/* crude guess: gain from the output change, a tenth of the log as time constants */
+		lfPar[0] = Step->lfDeltaY / Step->lfU;
+		lfPar[1] = 0.1 * (Step->Time[Step->uLast - 1] - Step->lfT0);
+		lfPar[2] = (sOrder == SOPDT) ? 0.5 * lfPar[1] : 0;
+		lfPar[sOrder + 1] = 0;
+	}
+
+	SysIdConstrain(lfPar, lfPar, sOrder);
+
+} // End: SysIdStart()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SYSIDREFINE() takes up to SYSID_ITER Gauss-Newton iter-
+*  ations on every uStride-th sample of the transient,
+*  then one on every sample of the log.
+*
+*  Outputs:
+*     number of iterations taken
+*  -------------------------------------------------------  *
+*/
+static unsigned SysIdRefine (const STEPDATA *Step, short sOrder, double *lfPar)
+{
+	STEPDATA Window, Full;
+
+	double lfGain, lfLambda = 1e-3;
+
+	unsigned i, uNbrIter = 0;
+
+	Window       = *Step;
+	Window.uLast = Step->uSettle;
+
+	for (i = 0; i < SYSID_ITER; i++)
+	{
+		lfGain = SysIdGaussNewton(&Window, sOrder, lfPar, &lfLambda, 10);
+		if (lfGain < 0)
+			break;
+
+		uNbrIter++;
+
+		if (lfGain < SYSID_TOL)
+			break;
+	}
+
+	if (Step->uStride > 1 || Step->uSettle < Step->uLast)
+	{
+		Full         = *Step;
+		Full.uStride = 1;
+
+		if (SysIdGaussNewton(&Full, sOrder, lfPar, &lfLambda, 2) >= 0)
+			uNbrIter++;
+	}
+
+	return uNbrIter;
+} // End: SysIdRefine()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SYSIDSTEP() fits a plus-dead-time model to the step re-
+*  sponse of a log: a linear least-squares first guess
+*  (SysIdLeastSquares()) refined by up to SYSID_ITER damp-
+*  ed Gauss-Newton iterations on the output error. These
+*  use at most SYSID_MAXFIT evenly spread samples of the
+*  transient; a last iteration uses every sample of the
+*  log, so a long log costs a handful of passes. A SOPDT fit also starts from the FOPDT fit
+*  with a small T2 (SYSID_T2), whichever start has the
+*  lower error, so it never fits worse than the FOPDT.
+*
+*  Inputs:
+*     *Data : log with an input step, e.g. of the STEP case
+*     sOrder: FOPDT or SOPDT
+*
+*  Outputs:
+*     *Model: fitted model and fit quality
+*     0 on success, -1 on failure
+*  -------------------------------------------------------  *
+*/
+int SysIdStep (const DATASET *Data, short sOrder, SYSIDMODEL *Model)
+{
+	STEPDATA Step, Window;
+
+	double lfPar[SYSID_MAXPAR], lfFirst[SYSID_MAXPAR], lfSeed[SYSID_MAXPAR], lfSse, lfMean, lfVar;
+
+	unsigned i, n;
+
+	if (StepFind(Data, &Step) != 0)
+		return -1;
+
+	SysIdStart(&Step, sOrder, lfPar);
+
+	Model->uNbrIter = 0;
+
+	if (sOrder == SOPDT)
+	{
+		SysIdStart(&Step, FOPDT, lfFirst);
+		Model->uNbrIter += SysIdRefine(&Step, FOPDT, lfFirst);
+
+		lfSeed[0] = lfFirst[0];
+		lfSeed[1] = lfFirst[1];
+		lfSeed[2] = SYSID_T2 * lfFirst[1];
+		lfSeed[3] = lfFirst[2];
+
+		Window       = Step;
+		Window.uLast = Step.uSettle;
+
+		if (SysIdSse(&Window, lfSeed, SOPDT, NULL, NULL) < SysIdSse(&Window, lfPar, SOPDT, NULL, NULL))
+			memcpy(lfPar, lfSeed, sizeof(lfSeed));
+	}
+
+	Model->uNbrIter += SysIdRefine(&Step, sOrder, lfPar);
+
+	/* fit quality */
+	Step.uStride = 1;
+
+	lfSse = SysIdSse(&Step, lfPar, sOrder, NULL, NULL);
+
+	for (i = Step.uFirst, lfMean = 0, lfVar = 0; i < Step.uLast; i++)
+	{
+		lfMean += Step.Output[i] - Step.lfY0;
+		lfVar  += (Step.Output[i] - Step.lfY0) * (Step.Output[i] - Step.lfY0);
+	}
+
+	n       = Step.uLast - Step.uFirst;
+	lfMean /= n;
+	lfVar  -= n * lfMean * lfMean;
+
+	Model->sOrder = sOrder;
+	Model->fK     = lfPar[0];
+	Model->fTau1  = lfPar[1];
+	Model->fTau2  = (sOrder == SOPDT) ? lfPar[2] : 0;
+	Model->fTheta = lfPar[sOrder + 1];
+	Model->fRmse  = sqrt(lfSse / n);
+	Model->fFit   = 100 * (1 - sqrt(lfSse / max(lfVar, eps)));
+
+	return 0;
+} // End: SysIdStep()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SYSIDCRITICAL() returns the critical point of a model,
+*  where its phase is -180 deg, in the form of a relay
+*  result, so every rule of TUNE_RULES applies to it.
+*
+*  Inputs:
+*     *Model: identified model
+*
+*  Outputs:
+*     *Relay: critical gain and period, static gain
+*     0 on success, -1 if the phase never reaches -180 deg
+*  -------------------------------------------------------  *
+*/
+int SysIdCritical (const SYSIDMODEL *Model, RELAYRESULT *Relay)
+{
+	double lfLow = 0, lfHigh = 1, w = 1;
+
+	unsigned i;
+
+	#define PHASE(w)   (atan(Model->fTau1 * (w)) + atan(Model->fTau2 * (w)) + Model->fTheta * (w))
+
+	memset(Relay, 0, sizeof(RELAYRESULT));
+
+	/* a first-order model needs a dead time to reach -180 deg */
+	if (Model->fK <= 0 || (Model->sOrder == FOPDT && Model->fTheta <= 0))
+		return -1;
+
+	for (i = 0; PHASE(lfHigh) < pi && i < 60; i++)
+		lfHigh *= 2;
+
+	if (PHASE(lfHigh) < pi)
+		return -1;
+
+	for (i = 0; i < 60; i++)
+	{
+		w = 0.5 * (lfLow + lfHigh);
+
+		if (PHASE(w) < pi)
+			lfLow = w;
+		else
+			lfHigh = w;
+	}
+
+	#undef PHASE
+
+	Relay->fKu   = sqrt((1 + Model->fTau1 * Model->fTau1 * w * w) * (1 + Model->fTau2 * Model->fTau2 * w * w)) / Model->fK;
+	Relay->fPu   = 2 * pi / w;
+	Relay->fGain = Model->fK;
+
+	return 0;
+} // End: SysIdCritical()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SYSIDSIMC() applies the SIMC rule (tau_c = theta) to a
+*  model: PI for a FOPDT, series PID for a SOPDT, turned
+*  into the ideal form of PIDCtrl(). tau_c is kept at
+*  least a tenth of T1, so a short or zero dead time does
+*  not give an unbounded gain. A negative plant gain gives
+*  a negative controller gain.
+*
+*  Inputs:
+*     *Model: identified model
+*
+*  Outputs:
+*     *PID: PID gains
+*     0 on success, -1 on a zero gain
+*  -------------------------------------------------------  *
+*/
+int SysIdSimc (const SYSIDMODEL *Model, PIDSET *PID)
+{
+	float fTauC, fKc, fTi, fTd;
+
+	if (fabs(Model->fK) < eps)
+		return -1;
+
+	fTauC = max(Model->fTheta, 0.1 * Model->fTau1);
+
+	fKc = Model->fTau1 / (Model->fK * (fTauC + Model->fTheta));
+	fTi = min(Model->fTau1, 4 * (fTauC + Model->fTheta));
+	fTd = Model->fTau2;
+
+	PID->K  = fKc * (1 + fTd / fTi);
+	PID->Ti = fTi + fTd;
+	PID->Td = fTi * fTd / (fTi + fTd);
+	PID->N  = RULE_N;
+
+	return 0;
+} // End: SysIdSimc()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SYSIDJOB() fits the model of order uJob + 1.
+*  -------------------------------------------------------  *
+*/
+static void SysIdJob (void *pCtx, unsigned uJob)
+{
+	SYSIDCTX *Ctx = pCtx;
+
+	Ctx->iStatus[uJob] = SysIdStep(Ctx->Data, uJob + 1, &Ctx->Model[uJob]);
+
+} // End: SysIdJob()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SYSIDREPORT() fits both models to the step of a log,
+*  side by side on two threads, prints them with their
+*  fit quality and prints the PID gains of every tuning
+*  rule for the better one.
+*
+*  Inputs:
+*     *Data: log with an input step
+*  -------------------------------------------------------  *
+*/
+void SysIdReport (const DATASET *Data)
+{
+	SYSIDCTX Ctx;
+
+	SYSIDMODEL *Model, *Best;
+
+	RELAYRESULT Critical;
+
+	PIDSET PID[NBR_RULES], Simc;
+
+	int iStatus[NBR_RULES], *iOk;
+
+	double lfStart, lfElapsed;
+
+	unsigned i;
+
+	Ctx.Data = Data;
+	Model    = Ctx.Model;
+	iOk      = Ctx.iStatus;
+
+	lfStart = WallClock();
+	WorkerRun(2, 2, SysIdJob, &Ctx);
+	lfElapsed = WallClock() - lfStart;
+
+	if (iOk[0] != 0 && iOk[1] != 0)
+		return;
+
+	printf("\n%-6s %8s %8s %8s %8s | %10s %8s %5s\n", "model", "K", "T1 [s]", "T2 [s]", "L [s]", "RMSE", "fit [%]", "iter");
+
+	for (i = 0; i < 2; i++)
+	{
+		if (iOk[i] == 0)
+			printf("%-6s %8.4f %8.3f %8.3f %8.3f | %10.3g %8.2f %5u\n", (i == 0) ? "FOPDT" : "SOPDT",
+			       Model[i].fK, Model[i].fTau1, Model[i].fTau2, Model[i].fTheta,
+			       Model[i].fRmse, Model[i].fFit, Model[i].uNbrIter);
+	}
+
+	printf("%u samples identified in %.3f sec\n", Data->Length, lfElapsed);
+
+	Best = (iOk[1] == 0 && (iOk[0] != 0 || Model[1].fFit > Model[0].fFit)) ? &Model[1] : &Model[0];
+
+	printf("\nPID gains from the %s model:\n%-16s %8s %8s %8s\n",
+	       (Best->sOrder == FOPDT) ? "FOPDT" : "SOPDT", "rule", "K", "Ti", "Td");
+
+	if (SysIdSimc(Best, &Simc) == 0)
+		printf("%-16s %8.3f %8.3f %8.3f\n", "SIMC (model)", Simc.K, Simc.Ti, Simc.Td);
+
+	if (SysIdCritical(Best, &Critical) != 0)
+	{
+		puts("The model has no critical point, the relay rules do not apply.");
+		return;
+	}
+
+	TuneRulesAll(&Critical, PID, iStatus);
+
+	for (i = 0; i < NBR_RULES; i++)
+	{
+		if (iStatus[i] == 0)
+			printf("%-16s %8.3f %8.3f %8.3f\n", TuneRuleName(i), PID[i].K, PID[i].Ti, PID[i].Td);
+	}
+
+} // End: SysIdReport()
+
+
+/**
+*  -------------------------------------------------------  *
+*  SYSIDRUN() identifies the plant from the step response
+*  in a log file (see SysIdReport()).
+*
+*  Inputs:
+*     cFileName: log written by SaveIOData() or LogOpen()
+*
+*  Outputs:
+*     0 on success, -1 if the log cannot be read
+*  -------------------------------------------------------  *
+*/
+int SysIdRun (const char *cFileName)
+{
+	DATASET Data;
+
+	Data = ReadIOData(cFileName);
+	if (Data.pImage == NULL)
+		return -1;
+
+	SysIdReport(&Data);
+	FreeIOData(&Data);
+
+	return 0;
+} // End: SysIdRun()
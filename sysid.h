@@ -0,0 +1,41 @@
+#ifndef __SYSID_H__
+#define __SYSID_H__
+
+#include "data_treatment.h"
+#include "tune_rules.h"
+
+#define SYSID_ITER    10     // maximum Gauss-Newton iterations
+#define SYSID_START   0.02   // response start, fraction of the output change
+#define SYSID_END     0.98   // end of the transient, fraction of the output change
+#define SYSID_MARGIN  0.5    // samples regressed past the transient, fraction of its length
+#define SYSID_T2      0.001   // T2 of the SOPDT start from the FOPDT fit, fraction of T1
+
+enum SysIdOrder
+{
+	FOPDT = 1,	// K exp(-theta s) / (tau1 s + 1)
+	SOPDT = 2	// K exp(-theta s) / ((tau1 s + 1)(tau2 s + 1))
+};
+
+// plus-dead-time model fitted to a step response
+typedef struct tagSysIdModel {
+	short    sOrder;		// FOPDT or SOPDT
+	float    fK;			// static gain
+	float    fTau1;		// dominant time constant [sec]
+	float    fTau2;		// second time constant [sec], 0 for FOPDT
+	float    fTheta;		// dead time [sec]
+	float    fRmse;		// root mean square of the output error
+	float    fFit;			// normalized fit 100 (1 - |y - ym| / |y - mean(y)|) [%]
+	unsigned uNbrIter;	// Gauss-Newton iterations taken
+} SYSIDMODEL;
+
+int SysIdStep (const DATASET *Data, short sOrder, SYSIDMODEL *Model);
+
+int SysIdCritical (const SYSIDMODEL *Model, RELAYRESULT *Relay);
+
+int SysIdSimc (const SYSIDMODEL *Model, PIDSET *PID);
+
+void SysIdReport (const DATASET *Data);
+
+int SysIdRun (const char *cFileName);
+
+#endif // __SYSID_H__
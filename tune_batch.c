@@ -0,0 +1,435 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "tune_batch.h"
+#include "worker.h"
+#include "util_func.h"
+
+#define TUNE_PATH_LEN   512   // maximum length of an output path
+#define TUNE_RULE_BLOCK 64    // plants per call of TuneRuleBatch()
+
+// data shared by the tuning jobs
+typedef struct tagTuneCtx {
+	const SCENARIO *Plants;
+	TUNERESULT     *Results;
+} TUNECTX;
+
+// data shared by the rule scoring jobs
+typedef struct tagRuleCtx {
+	const SCENARIO *Plants;
+	RULESCORE      *Scores;
+} RULECTX;
+
+
+/**
+*  -------------------------------------------------------  *
+*  TUNEPLANT() sets up the simulation of a plant of the
+*  list: horizon, sampling time and discretized model.
+*
+*  Outputs:
+*     *SimSet, *Case: settings of the closed loop
+*     *Disc         : plant discretized at its Ts
+*     0 on success, -1 if the plant cannot be discretized
+*  -------------------------------------------------------  *
+*/
+static int TunePlant (const SCENARIO *Scn, SIMSET *SimSet, CASESET *Case, LTIDISC *Disc)
+{
+	SimSet->fTs      = Scn->fTs;
+	SimSet->uNbrIter = Scn->fTsim / SimSet->fTs;
+
+	*Case       = Scn->Case;
+	Case->Plant = NULL;
+
+	if (Scn->bModel)
+	{
+		if (LtiGetDisc(&Scn->Model, Scn->fTs, Scn->sMethod, Disc) != 0)
+			return -1;
+
+		Case->Plant = Disc;
+	}
+
+	return 0;
+} // End: TunePlant()
+
+
+/**
+*  -------------------------------------------------------  *
+*  TUNEJOB() runs the relay experiment of one plant. The
+*  loop is only stepped until the tuner concludes, the
+*  horizon of the plant being the time limit.
+*  -------------------------------------------------------  *
+*/
+static void TuneJob (void *pCtx, unsigned uPlant)
+{
+	TUNECTX *Ctx = pCtx;
+
+	const SCENARIO *Scn = &Ctx->Plants[uPlant];
+
+	TUNERESULT *Result = &Ctx->Results[uPlant];
+
+	SIMSET SimSet;
+
+	CASESET Case;
+
+	LTIDISC Disc;
+
+	LOOP Loop;
+
+	Result->iStatus = TunePlant(Scn, &SimSet, &Case, &Disc);
+	if (Result->iStatus != 0)
+		return;
+
+	Case.sSimCase = AUTO;
+
+	LoopInit(&Loop, &Case);
+
+	while (!Loop.bTuned && Loop.uIter < SimSet.uNbrIter)
+		LoopStep(&Loop, &SimSet);
+
+	Result->fTuneTime = Loop.uIter * SimSet.fTs;
+
+	/* an oscillation inside the hysteresis gives no critical gain */
+	if (!Loop.bTuned || !isfinite(Loop.Tune.Relay.fKu) || Loop.Tune.Relay.fKu <= 0)
+	{
+		Result->iStatus = -1;
+		return;
+	}
+
+	Result->Relay   = Loop.Tune.Relay;
+	Result->PID     = Loop.PID;
+	Result->iStatus = 0;
+
+} // End: TuneJob()
+
+
+/**
+*  -------------------------------------------------------  *
+*  TUNEBATCH() auto-tunes a set of plants with the relay
+*  experiment of AutoTune(), one plant per job on a pool
+*  of threads.
+*
+*  Inputs:
+*     *Plants    : plants, as read by ScenarioRead() (the
+*                  case is ignored)
+*     uNbrPlants : number of plants
+*     uNbrThreads: number of threads (0 uses all processors)
+*
+*  Outputs:
+*     *Results: one result per plant
+*  -------------------------------------------------------  *
+*/
+void TuneBatch (const SCENARIO *Plants, unsigned uNbrPlants, TUNERESULT *Results, unsigned uNbrThreads)
+{
+	TUNECTX Ctx;
+
+	Ctx.Plants  = Plants;
+	Ctx.Results = Results;
+
+	WorkerRun(uNbrThreads, uNbrPlants, TuneJob, &Ctx);
+
+} // End: TuneBatch()
+
+
+/**
+*  -------------------------------------------------------  *
+*  RULEJOB() runs the closed loop of one tuning rule on
+*  one plant and scores its set-point response.
+*  -------------------------------------------------------  *
+*/
+static void RuleJob (void *pCtx, unsigned uJob)
+{
+	RULECTX *Ctx = pCtx;
+
+	const SCENARIO *Scn = &Ctx->Plants[uJob / NBR_RULES];
+
+	RULESCORE *Score = &Ctx->Scores[uJob];
+
+	SIMSET SimSet;
+
+	CASESET Case;
+
+	LTIDISC Disc;
+
+	LOOP Loop;
+
+	unsigned i;
+
+	if (Score->iStatus != 0)
+		return;
+
+	Score->iStatus = TunePlant(Scn, &SimSet, &Case, &Disc);
+	if (Score->iStatus != 0)
+		return;
+
+	Case.sSimCase = MANUAL;
+	Case.PID      = Score->PID;
+
+	LoopInit(&Loop, &Case);
+	MetricsInit(&Score->Metrics, (float)Case.sSetpoint / PREC);
+
+	for (i = 0; i < SimSet.uNbrIter; i++)
+	{
+		LoopStep(&Loop, &SimSet);
+		MetricsUpdate(&Score->Metrics, i * SimSet.fTs, (float)Loop.sSysOut / PREC, SimSet.fTs);
+	}
+
+	MetricsFinish(&Score->Metrics, SimSet.fTs);
+
+} // End: RuleJob()
+
+
+/**
+*  -------------------------------------------------------  *
+*  TUNEBATCHRULES() applies every tuning rule of TUNE_RU-
+*  LES to the relay results of a batch and scores the set-
+*  point response of each rule on each plant, one closed
+*  loop per job on a pool of threads. The relay experi-
+*  ments are not run again: the gains come from TuneRule-
+*  Batch(), one rule at a time over a block of plants.
+*  Plants with a zero set-point are not scored.
+*
+*  Inputs:
+*     *Plants    : plants, as read by ScenarioRead()
+*     uNbrPlants : number of plants
+*     *Results   : relay results of TuneBatch()
+*     uNbrThreads: number of threads (0 uses all processors)
+*
+*  Outputs:
+*     *Scores: NBR_RULES scores per plant, plant by plant
+*  -------------------------------------------------------  *
+*/
+void TuneBatchRules (
+		   const SCENARIO *Plants,
+		   unsigned uNbrPlants,
+		   const TUNERESULT *Results,
+		   RULESCORE *Scores,
+		   unsigned uNbrThreads
+		   )
+{
+	RULECTX Ctx;
+
+	RELAYRESULT Relay[TUNE_RULE_BLOCK];
+
+	PIDSET PID[TUNE_RULE_BLOCK];
+
+	int iStatus[TUNE_RULE_BLOCK];
+
+	unsigned i, j, r, uNbr;
+
+	/* one rule at a time over a block of plants */
+	for (i = 0; i < uNbrPlants; i += TUNE_RULE_BLOCK)
+	{
+		uNbr = min(uNbrPlants - i, TUNE_RULE_BLOCK);
+
+		for (j = 0; j < uNbr; j++)
+			Relay[j] = Results[i + j].Relay;
+
+		for (r = 0; r < NBR_RULES; r++)
+		{
+			TuneRuleBatch(r, Relay, PID, iStatus, uNbr);
+
+			for (j = 0; j < uNbr; j++)
+			{
+				Scores[(i + j) * NBR_RULES + r].PID     = PID[j];
+				Scores[(i + j) * NBR_RULES + r].iStatus = (Results[i + j].iStatus != 0) ? -1 : iStatus[j];
+
+				/* no set-point response to score */
+				if (Plants[i + j].Case.sSetpoint == 0)
+					Scores[(i + j) * NBR_RULES + r].iStatus = -1;
+			}
+		}
+	}
+
+	Ctx.Plants = Plants;
+	Ctx.Scores = Scores;
+
+	WorkerRun(uNbrThreads, uNbrPlants * NBR_RULES, RuleJob, &Ctx);
+
+} // End: TuneBatchRules()
+
+
+/**
+*  -------------------------------------------------------  *
+*  RULEREPORT() prints, for every tuning rule, on how many
+*  plants it applies, on how many it has the lowest IAE
+*  and its mean IAE and overshoot. One line per rule and
+*  plant goes to the file Rules if given.
+*  -------------------------------------------------------  *
+*/
+static void RuleReport (const SCENARIO *Plants, unsigned uNbrPlants, const RULESCORE *Scores, FILE *Rules)
+{
+	const RULESCORE *Score;
+
+	unsigned uNbrValid[NBR_RULES] = {0}, uNbrBest[NBR_RULES] = {0};
+
+	double lfIAE[NBR_RULES] = {0}, lfOS[NBR_RULES] = {0};
+
+	unsigned i, r;
+
+	int iBest;
+
+	if (Rules)
+		fprintf(Rules, "%-16s %-16s %8s %8s %8s | %8s %8s %8s %8s\n",
+		        "plant", "rule", "K", "Ti", "Td", "IAE", "OS [%]", "Tr [s]", "Ts [s]");
+
+	for (i = 0; i < uNbrPlants; i++)
+	{
+		iBest = -1;
+
+		for (r = 0; r < NBR_RULES; r++)
+		{
+			Score = &Scores[i * NBR_RULES + r];
+
+			if (Score->iStatus != 0)
+				continue;
+
+			uNbrValid[r]++;
+			lfIAE[r] += Score->Metrics.fIAE;
+			lfOS[r]  += Score->Metrics.fOvershoot;
+
+			if (iBest < 0 || Score->Metrics.fIAE < Scores[i * NBR_RULES + iBest].Metrics.fIAE)
+				iBest = r;
+
+			if (Rules)
+				fprintf(Rules, "%-16s %-16s %8.3f %8.3f %8.3f | %8.3f %8.2f %8.2f %8.2f\n",
+				        Plants[i].cName, TuneRuleName(r), Score->PID.K, Score->PID.Ti, Score->PID.Td,
+				        Score->Metrics.fIAE, Score->Metrics.fOvershoot,
+				        Score->Metrics.fRiseTime, Score->Metrics.fSettleTime);
+		}
+
+		if (iBest >= 0)
+			uNbrBest[iBest]++;
+	}
+
+	printf("\n%-16s %8s %8s | %8s %8s\n", "rule", "plants", "best", "mean IAE", "mean OS");
+
+	for (r = 0; r < NBR_RULES; r++)
+	{
+		if (uNbrValid[r] == 0)
+			printf("%-16s %8u %8u | %8s %8s\n", TuneRuleName(r), 0, 0, "-", "-");
+		else
+			printf("%-16s %8u %8u | %8.3f %8.2f\n", TuneRuleName(r), uNbrValid[r], uNbrBest[r],
+			       lfIAE[r] / uNbrValid[r], lfOS[r] / uNbrValid[r]);
+	}
+
+} // End: RuleReport()
+
+
+/**
+*  -------------------------------------------------------  *
+*  TUNEBATCHRUN() auto-tunes every plant of a scenario
+*  file and prints the critical points with their confi-
+*  dence intervals, the static gains and the Z-N gains.
+*  The table is also written to <cOutDir>/tune_summary.txt.
+*  Every tuning rule is then scored on every plant from
+*  the same relay results and compared, the details going
+*  to <cOutDir>/tune_rules.txt.
+*
+*  Inputs:
+*     cFileName  : plant list in the scenario file format
+*     cOutDir    : output directory (NULL: no file)
+*     uNbrThreads: number of threads (0 uses all processors)
+*
+*  Outputs:
+*     0 if every plant is tuned, -1 otherwise
+*  -------------------------------------------------------  *
+*/
+int TuneBatchRun (const char *cFileName, const char *cOutDir, unsigned uNbrThreads)
+{
+	SCENARIO *Plants;
+
+	TUNERESULT *Results;
+
+	RULESCORE *Scores;
+
+	FILE *Summary = NULL, *Rules = NULL;
+
+	char cPath[TUNE_PATH_LEN], cLine[SCN_LINE_LEN];
+
+	double lfStart, lfElapsed;
+
+	unsigned i, uNbrPlants, uNbrFailed = 0;
+
+	if (ScenarioRead(cFileName, &Plants, &uNbrPlants) != 0)
+		return -1;
+
+	Results = calloc(uNbrPlants, sizeof(TUNERESULT));
+	Scores  = calloc(uNbrPlants * NBR_RULES, sizeof(RULESCORE));
+	if (Results == NULL || Scores == NULL)
+	{
+		puts("Error: memory allocaion failed!\n");
+		free(Results);
+		free(Scores);
+		free(Plants);
+		return -1;
+	}
+
+	lfStart = WallClock();
+	TuneBatch(Plants, uNbrPlants, Results, uNbrThreads);
+	lfElapsed = WallClock() - lfStart;
+
+	if (cOutDir != NULL)
+	{
+		snprintf(cPath, sizeof(cPath), "%s/tune_summary.txt", cOutDir);
+		Summary = fopen(cPath, "w");
+
+		if (!Summary)
+			perror("Error opening file");
+	}
+
+	sprintf(cLine, "%-16s %8s %7s %8s %7s %8s | %8s %8s %8s | %8s\n",
+	        "plant", "Ku", "+/-", "Pu [s]", "+/-", "Kp", "K", "Ti", "Td", "Tune [s]");
+	fputs(cLine, stdout);
+	if (Summary)
+		fputs(cLine, Summary);
+
+	for (i = 0; i < uNbrPlants; i++)
+	{
+		if (Results[i].iStatus != 0)
+		{
+			sprintf(cLine, "%-16s failed\n", Plants[i].cName);
+			uNbrFailed++;
+		}
+		else
+			sprintf(cLine, "%-16s %8.3f %7.3f %8.3f %7.3f %8.3f | %8.3f %8.3f %8.3f | %8.2f\n",
+			        Plants[i].cName, Results[i].Relay.fKu, Results[i].Relay.fKuCi,
+			        Results[i].Relay.fPu, Results[i].Relay.fPuCi, Results[i].Relay.fGain, Results[i].PID.K, Results[i].PID.Ti, Results[i].PID.Td, Results[i].fTuneTime);
+
+		fputs(cLine, stdout);
+		if (Summary)
+			fputs(cLine, Summary);
+	}
+
+	if (Summary)
+		fclose(Summary);
+
+	printf("\n%u plants tuned in %.3f sec (%u failed)\n", uNbrPlants - uNbrFailed, lfElapsed, uNbrFailed);
+
+	/* compare the tuning rules on the same relay results */
+	lfStart = WallClock();
+	TuneBatchRules(Plants, uNbrPlants, Results, Scores, uNbrThreads);
+	lfElapsed = WallClock() - lfStart;
+
+	if (cOutDir != NULL)
+	{
+		snprintf(cPath, sizeof(cPath), "%s/tune_rules.txt", cOutDir);
+		Rules = fopen(cPath, "w");
+
+		if (!Rules)
+			perror("Error opening file");
+	}
+
+	RuleReport(Plants, uNbrPlants, Scores, Rules);
+
+	if (Rules)
+		fclose(Rules);
+
+	printf("\n%u rules scored on %u plants in %.3f sec\n", NBR_RULES, uNbrPlants, lfElapsed);
+
+	free(Scores);
+	free(Results);
+	free(Plants);
+
+	return (uNbrFailed > 0) ? -1 : 0;
+} // End: TuneBatchRun()
@@ -0,0 +1,34 @@
+#ifndef __TUNE_BATCH_H__
+#define __TUNE_BATCH_H__
+
+#include "scenario.h"
+#include "tune_rules.h"
+
+// outcome of the relay experiment of one plant
+typedef struct tagTuneResult {
+	RELAYRESULT Relay;		// critical point and relay settings
+	PIDSET      PID;		// Ziegler-Nichols gains
+	float       fTuneTime;	// length of the relay experiment [sec]
+	int         iStatus;	// 0 on success, -1 no sustained oscillation
+} TUNERESULT;
+
+// closed-loop score of one tuning rule on one plant
+typedef struct tagRuleScore {
+	PIDSET  PID;			// gains of the rule
+	METRICS Metrics;		// set-point response
+	int     iStatus;		// 0 on success, -1 if the rule or the relay result fails
+} RULESCORE;
+
+void TuneBatch (const SCENARIO *Plants, unsigned uNbrPlants, TUNERESULT *Results, unsigned uNbrThreads);
+
+void TuneBatchRules (
+		   const SCENARIO *Plants,
+		   unsigned uNbrPlants,
+		   const TUNERESULT *Results,
+		   RULESCORE *Scores,
+		   unsigned uNbrThreads
+		   );
+
+int TuneBatchRun (const char *cFileName, const char *cOutDir, unsigned uNbrThreads);
+
+#endif // __TUNE_BATCH_H__
@@ -0,0 +1,88 @@
+#include <stdio.h>
+
+#include "tune_rules.h"
+
+
+/**
+*  -------------------------------------------------------  *
+*  TUNERULENAME() returns the name of a tuning rule.
+*
+*  Inputs:
+*     sRule: rule, see TUNE_RULES
+*  -------------------------------------------------------  *
+*/
+const char *TuneRuleName (short sRule)
+{
+	static const char *cNames[NBR_RULES] = {
+#define TUNE_RULE_NAME(id, func, name)   name,
+		TUNE_RULES(TUNE_RULE_NAME)
+#undef TUNE_RULE_NAME
+	};
+
+	if (sRule < 0 || sRule >= NBR_RULES)
+		return "unknown";
+
+	return cNames[sRule];
+} // End: TuneRuleName()
+
+
+/**
+*  -------------------------------------------------------  *
+*  TUNERULEBATCH() applies one tuning rule to many relay
+*  results. The rule is chosen once; each case is a loop
+*  over its own inlined rule, with no call per result.
+*
+*  Inputs:
+*     sRule : rule, see TUNE_RULES
+*     *Relay: relay experiment results
+*     uNbr  : number of results
+*
+*  Outputs:
+*     *PID    : one set of PID gains per result
+*     *iStatus: one status per result, 0 or -1 if the rule
+*               does not apply
+*  -------------------------------------------------------  *
+*/
+void TuneRuleBatch (short sRule, const RELAYRESULT *Relay, PIDSET *PID, int *iStatus, unsigned uNbr)
+{
+	unsigned i;
+
+	switch (sRule)
+	{
+#define TUNE_RULE_LOOP(id, func, name)                 \
+		case id:                                       \
+			for (i = 0; i < uNbr; i++)                 \
+				iStatus[i] = func(&Relay[i], &PID[i]); \
+			break;
+		TUNE_RULES(TUNE_RULE_LOOP)
+#undef TUNE_RULE_LOOP
+
+		default:
+			for (i = 0; i < uNbr; i++)
+				iStatus[i] = -1;
+	}
+
+} // End: TuneRuleBatch()
+
+
+/**
+*  -------------------------------------------------------  *
+*  TUNERULESALL() applies every tuning rule to one relay
+*  result.
+*
+*  Inputs:
+*     *Relay: relay experiment result
+*
+*  Outputs:
+*     *PID    : NBR_RULES sets of PID gains, in rule order
+*     *iStatus: NBR_RULES statuses, 0 or -1 if the rule does
+*               not apply
+*  -------------------------------------------------------  *
+*/
+void TuneRulesAll (const RELAYRESULT *Relay, PIDSET *PID, int *iStatus)
+{
+#define TUNE_RULE_ALL(id, func, name)   iStatus[id] = func(Relay, &PID[id]);
+	TUNE_RULES(TUNE_RULE_ALL)
+#undef TUNE_RULE_ALL
+
+} // End: TuneRulesAll()
@@ -0,0 +1,143 @@
+#ifndef __TUNE_RULES_H__
+#define __TUNE_RULES_H__
+
+#include <math.h>
+
+#include "control_system.h"
+#include "util_func.h"
+
+#define RULE_N   100   // derivative filter factor of every rule
+
+/* tuning rules over a relay experiment: X(id, function, name). Every
+   rule is an inline function below, so a loop over one rule compiles
+   to straight-line code (see TuneRuleBatch()) */
+#define TUNE_RULES(X)                                         \
+	X(RULE_ZN,     RuleZieglerNichols, "Ziegler-Nichols")    \
+	X(RULE_TL,     RuleTyreusLuyben,   "Tyreus-Luyben")      \
+	X(RULE_PESSEN, RulePessen,         "Pessen integral")    \
+	X(RULE_SOMEOS, RuleSomeOvershoot,  "some overshoot")     \
+	X(RULE_NOOS,   RuleNoOvershoot,    "no overshoot")       \
+	X(RULE_AMIGO,  RuleAmigo,          "AMIGO")              \
+	X(RULE_SIMC,   RuleSimc,           "SIMC")
+
+enum TuneRule
+{
+#define TUNE_RULE_ID(id, func, name)   id,
+	TUNE_RULES(TUNE_RULE_ID)
+#undef TUNE_RULE_ID
+	NBR_RULES
+};
+
+
+/**
+*  -------------------------------------------------------  *
+*  Every rule maps the relay result to PID gains (ideal
+*  form) and returns 0, or -1 if the result does not sup-
+*  port it (PID is then left unchanged).
+*  -------------------------------------------------------  *
+*/
+
+// classic Ziegler-Nichols
+static inline int RuleZieglerNichols (const RELAYRESULT *Relay, PIDSET *PID)
+{
+	PID->K  = 0.6   * Relay->fKu;
+	PID->Ti = 0.5   * Relay->fPu;
+	PID->Td = 0.125 * Relay->fPu;
+	PID->N  = RULE_N;
+
+	return 0;
+}
+
+// Tyreus-Luyben, detuned for less oscillatory loops
+static inline int RuleTyreusLuyben (const RELAYRESULT *Relay, PIDSET *PID)
+{
+	PID->K  = Relay->fKu / 2.2;
+	PID->Ti = 2.2 * Relay->fPu;
+	PID->Td = Relay->fPu / 6.3;
+	PID->N  = RULE_N;
+
+	return 0;
+}
+
+// Pessen integral rule, aggressive disturbance rejection
+static inline int RulePessen (const RELAYRESULT *Relay, PIDSET *PID)
+{
+	PID->K  = 0.7  * Relay->fKu;
+	PID->Ti = 0.4  * Relay->fPu;
+	PID->Td = 0.15 * Relay->fPu;
+	PID->N  = RULE_N;
+
+	return 0;
+}
+
+// Ziegler-Nichols variant with some overshoot
+static inline int RuleSomeOvershoot (const RELAYRESULT *Relay, PIDSET *PID)
+{
+	PID->K  = Relay->fKu / 3;
+	PID->Ti = 0.5 * Relay->fPu;
+	PID->Td = Relay->fPu / 3;
+	PID->N  = RULE_N;
+
+	return 0;
+}
+
+// Ziegler-Nichols variant without overshoot
+static inline int RuleNoOvershoot (const RELAYRESULT *Relay, PIDSET *PID)
+{
+	PID->K  = 0.2 * Relay->fKu;
+	PID->Ti = 0.5 * Relay->fPu;
+	PID->Td = Relay->fPu / 3;
+	PID->N  = RULE_N;
+
+	return 0;
+}
+
+// AMIGO frequency-response rule, needs the gain ratio kappa = 1/(Kp Ku) < 1
+static inline int RuleAmigo (const RELAYRESULT *Relay, PIDSET *PID)
+{
+	float fKappa;
+
+	if (Relay->fGain <= 0 || Relay->fKu <= 0)
+		return -1;
+
+	fKappa = 1 / (Relay->fGain * Relay->fKu);
+
+	if (fKappa >= 1)
+		return -1;
+
+	PID->K  = (0.3 - 0.1 * pow(fKappa, 4)) * Relay->fKu;
+	PID->Ti = 0.6 * Relay->fPu / (1 + 2 * fKappa);
+	PID->Td = 0.15 * (1 - fKappa) * Relay->fPu / (1 - 0.95 * fKappa);
+	PID->N  = RULE_N;
+
+	return 0;
+}
+
+/* SIMC PI rule (tau_c = theta) on the first-order plus dead-time model
+   Kp exp(-theta s)/(tau s + 1) through the critical point */
+static inline int RuleSimc (const RELAYRESULT *Relay, PIDSET *PID)
+{
+	float fWu, fTau, fTheta;
+
+	if (Relay->fGain <= 0 || Relay->fGain * Relay->fKu <= 1 || Relay->fPu <= 0)
+		return -1;
+
+	fWu    = 2 * pi / Relay->fPu;
+	fTau   = sqrt(Relay->fGain * Relay->fKu * Relay->fGain * Relay->fKu - 1) / fWu;
+	fTheta = (pi - atan(fTau * fWu)) / fWu;
+
+	PID->K  = fTau / (2 * Relay->fGain * fTheta);
+	PID->Ti = min(fTau, 8 * fTheta);
+	PID->Td = 0;
+	PID->N  = RULE_N;
+
+	return 0;
+}
+
+const char *TuneRuleName (short sRule);
+
+void TuneRuleBatch (short sRule, const RELAYRESULT *Relay, PIDSET *PID, int *iStatus, unsigned uNbr);
+
+void TuneRulesAll (const RELAYRESULT *Relay, PIDSET *PID, int *iStatus);
+
+#endif // __TUNE_RULES_H__
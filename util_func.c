@@ -1,3 +1,34 @@
 #include "util_func.h"
 
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif // #ifdef WIN32
 
+
+/**
+*  -------------------------------------------------------  *
+*  WALLCLOCK() returns a monotonic wall-clock time.
+*
+*  Outputs:
+*     lfTime: time in seconds from an arbitrary origin
+*  -------------------------------------------------------  *
+*/
+double WallClock (void)
+{
+#ifdef WIN32
+	LARGE_INTEGER Count, Freq;
+	
+	QueryPerformanceCounter(&Count);
+	QueryPerformanceFrequency(&Freq);
+	
+	return (double)Count.QuadPart / Freq.QuadPart;
+#else
+	struct timespec Now;
+	
+	clock_gettime(CLOCK_MONOTONIC, &Now);
+	
+	return Now.tv_sec + Now.tv_nsec * 1e-9;
+#endif // #ifdef WIN32
+} // End: WallClock()
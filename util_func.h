@@ -15,5 +15,6 @@
 #define pi		3.141593
 #define PREC	100
 
+double WallClock (void);
 
 #endif // __UTIL_FUNC_H__
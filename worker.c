@@ -0,0 +1,120 @@
+#include "worker.h"
+#include "util_func.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif // #ifdef WIN32
+
+#define WORKER_MAX_THREADS   256   // upper bound of the pool size
+
+// job queue shared by the workers
+typedef struct tagWorkQueue {
+	WORKFUNC          Work;		// job function
+	void             *pCtx;		// job context
+	unsigned          uNbrJobs;	// number of jobs
+	volatile unsigned uNext;		// next job to be claimed
+} WORKQUEUE;
+
+
+/**
+*  -------------------------------------------------------  *
+*  WORKERCOUNT() returns the number of online processors.
+*
+*  Outputs:
+*     uCount: number of processors (at least 1)
+*  -------------------------------------------------------  *
+*/
+unsigned WorkerCount (void)
+{
+	long lCount;
+
+#ifdef WIN32
+	SYSTEM_INFO SysInfo;
+	GetSystemInfo(&SysInfo);
+	lCount = SysInfo.dwNumberOfProcessors;
+#else
+	lCount = sysconf(_SC_NPROCESSORS_ONLN);
+#endif // #ifdef WIN32
+
+	if (lCount < 1)
+		lCount = 1;
+
+	return (unsigned)lCount;
+} // End: WorkerCount()
+
+
+/**
+*  -------------------------------------------------------  *
+*  WORKERMAIN() claims jobs from the queue until it is
+*  empty.
+*  -------------------------------------------------------  *
+*/
+static void *WorkerMain (void *pArg)
+{
+	WORKQUEUE *Queue = pArg;
+
+	unsigned uJob;
+
+	while ((uJob = __sync_fetch_and_add(&Queue->uNext, 1)) < Queue->uNbrJobs)
+		Queue->Work(Queue->pCtx, uJob);
+
+	return NULL;
+} // End: WorkerMain()
+
+
+/**
+*  -------------------------------------------------------  *
+*  WORKERRUN() executes uNbrJobs independent jobs on a
+*  pool of threads and returns when all of them are done.
+*  Jobs are claimed one by one, so uneven jobs are balan-
+*  ced between the threads.
+*
+*  Inputs:
+*     uNbrThreads: pool size (0 uses all processors)
+*     uNbrJobs   : number of jobs
+*     Work       : job function
+*     pCtx       : context passed to every job
+*  -------------------------------------------------------  *
+*/
+void WorkerRun (unsigned uNbrThreads, unsigned uNbrJobs, WORKFUNC Work, void *pCtx)
+{
+	WORKQUEUE Queue;
+
+	pthread_t Threads[WORKER_MAX_THREADS];
+
+	unsigned i, uStarted = 0;
+
+	Queue.Work     = Work;
+	Queue.pCtx     = pCtx;
+	Queue.uNbrJobs = uNbrJobs;
+	Queue.uNext    = 0;
+
+	if (uNbrThreads == 0)
+		uNbrThreads = WorkerCount();
+
+	uNbrThreads = min(uNbrThreads, WORKER_MAX_THREADS);
+	uNbrThreads = min(uNbrThreads, uNbrJobs);
+
+	/* the calling thread is one of the workers */
+	for (i = 1; i < uNbrThreads; i++)
+	{
+		if (pthread_create(&Threads[uStarted], NULL, WorkerMain, &Queue) != 0)
+		{
+			fprintf(stderr, "Warning: could not start worker thread %u.\n", i);
+			break;
+		}
+		uStarted++;
+	}
+
+	WorkerMain(&Queue);
+
+	for (i = 0; i < uStarted; i++)
+		pthread_join(Threads[i], NULL);
+
+} // End: WorkerRun()
@@ -0,0 +1,11 @@
+#ifndef __WORKER_H__
+#define __WORKER_H__
+
+// job executed by a worker thread: pCtx is shared, uJob is the job index
+typedef void (*WORKFUNC) (void *pCtx, unsigned uJob);
+
+unsigned WorkerCount (void);
+
+void WorkerRun (unsigned uNbrThreads, unsigned uNbrJobs, WORKFUNC Work, void *pCtx);
+
+#endif // __WORKER_H__